@@ -0,0 +1,147 @@
+#pragma once
+#include <google/protobuf/arena.h>
+#include <grpcpp/support/message_allocator.h>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+// protobuf arena 内存块的进程级复用池。
+// ArenaOptions 只接受函数指针，因此池是静态的；固定大小的块归还后放入空闲链表，
+// 其余大小（单次分配超过块大小时）直接交给 malloc/free
+class arenaBlockPool {
+public:
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+    static constexpr std::size_t MAX_CACHED_BLOCKS = 8192;  // 最多缓存 32MB
+
+    static void* allocate(std::size_t size) {
+        if (size == BLOCK_SIZE) {
+            Pool& pool = instance();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.head) {
+                FreeBlock* block = pool.head;
+                pool.head = block->next;
+                --pool.cached;
+                return block;
+            }
+        }
+        return std::malloc(size);
+    }
+
+    static void deallocate(void* block, std::size_t size) {
+        if (size == BLOCK_SIZE) {
+            Pool& pool = instance();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.cached < MAX_CACHED_BLOCKS) {
+                pool.head = new (block) FreeBlock{pool.head};
+                ++pool.cached;
+                return;
+            }
+        }
+        std::free(block);
+    }
+
+    // 所有 arena 共用的参数：每个块都是 BLOCK_SIZE，从池中取用
+    static google::protobuf::ArenaOptions options() {
+        google::protobuf::ArenaOptions options;
+        options.start_block_size = BLOCK_SIZE;
+        options.max_block_size = BLOCK_SIZE;
+        options.block_alloc = &arenaBlockPool::allocate;
+        options.block_dealloc = &arenaBlockPool::deallocate;
+        return options;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Pool {
+        std::mutex mutex;
+        FreeBlock* head = nullptr;
+        std::size_t cached = 0;
+    };
+
+    // 池中的块在进程退出时不再释放
+    static Pool& instance() {
+        static Pool* pool = new Pool();
+        return *pool;
+    }
+};
+
+// 回调 API 的消息分配器：请求与应答分配在每次 RPC 独占的 arena 上，RPC 结束时整体释放。
+// arena 连同其所属的 holder 复用，释放只是 Reset，块归还 arenaBlockPool；
+// 稳定状态下解析请求、填充应答都不再走堆分配（超过 SSO 长度的字符串字段除外，
+// 其缓冲区由 std::string 自行分配）。分配器必须比注册它的服务活得久
+template <typename Request, typename Response>
+class arenaMessageAllocator : public grpc::MessageAllocator<Request, Response> {
+public:
+    explicit arenaMessageAllocator(std::size_t max_cached = 4096) : max_cached_(max_cached) {}
+
+    ~arenaMessageAllocator() override {
+        while (free_) {
+            Holder* holder = free_;
+            free_ = holder->next_;
+            delete holder;
+        }
+    }
+
+    arenaMessageAllocator(const arenaMessageAllocator&) = delete;
+    arenaMessageAllocator& operator=(const arenaMessageAllocator&) = delete;
+
+    grpc::MessageHolder<Request, Response>* AllocateMessages() override {
+        Holder* holder = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_) {
+                holder = free_;
+                free_ = holder->next_;
+                --cached_;
+            }
+        }
+        if (!holder) {
+            holder = new Holder(this);
+        }
+        holder->prepare();
+        return holder;
+    }
+
+private:
+    class Holder : public grpc::MessageHolder<Request, Response> {
+    public:
+        explicit Holder(arenaMessageAllocator* owner)
+            : owner_(owner), arena_(arenaBlockPool::options()) {}
+
+        void prepare() {
+            this->set_request(google::protobuf::Arena::CreateMessage<Request>(&arena_));
+            this->set_response(google::protobuf::Arena::CreateMessage<Response>(&arena_));
+        }
+
+        void Release() override {
+            arena_.Reset();
+            owner_->recycle(this);
+        }
+
+        arenaMessageAllocator* const owner_;
+        google::protobuf::Arena arena_;
+        Holder* next_ = nullptr;
+    };
+
+    void recycle(Holder* holder) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cached_ < max_cached_) {
+                holder->next_ = free_;
+                free_ = holder;
+                ++cached_;
+                return;
+            }
+        }
+        delete holder;
+    }
+
+    const std::size_t max_cached_;
+    std::mutex mutex_;
+    Holder* free_ = nullptr;
+    std::size_t cached_ = 0;
+};
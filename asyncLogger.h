@@ -0,0 +1,467 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+
+// 日志参数，对应 config.ini 的 [log] 部分
+struct LogOptions {
+    std::string file = "grpc_server.log"; // file: 日志文件路径
+    std::string format = "json";          // format: json 或 kv（key=value）
+    std::string level = "info";           // level: off / error（只记失败）/ info（全部）
+    double sample_rate = 1.0;             // sample_rate: 成功请求的采样比例，失败请求始终记录
+    int max_file_mb = 64;                 // max_file_mb: 单个文件大小上限，超过后轮转
+    int max_files = 5;                    // max_files: 保留的历史文件数
+    int flush_interval_ms = 100;          // flush_interval_ms: 后台线程批量写盘的周期
+    int ring_size = 1024;                 // ring_size: 每个线程的环形缓冲区记录数
+};
+
+enum class LogOp : uint8_t { Insert, Update, Delete, Batch, Query, GetUser };
+
+// 定长二进制日志记录，请求线程只做定长拷贝，格式化全部在后台线程完成。
+// 各字段的含义随 op 而定，后台线程按 op 输出对应的字段名：
+//   单条操作/GetUser：name 为用户名，age 为年龄，count 为影响的记录数
+//   Batch：name 为模式（ATOMIC/BEST_EFFORT），count 为成功的操作数，total 为操作总数
+//   Query：name 为 name 前缀，age 与 max_age 为年龄区间，count 为返回的行数
+struct LogRecord {
+    int64_t timestamp_us;
+    int64_t count;
+    int64_t total;
+    int32_t age;
+    int32_t max_age;
+    LogOp op;
+    bool success;
+    uint8_t name_len;
+    uint8_t message_len;
+    char name[64];
+    char message[112];
+};
+
+// 异步结构化请求日志
+// 每个请求线程持有一个单生产者/单消费者的无锁环形缓冲区，缓冲区满时丢弃并计数；
+// 后台线程周期性收集所有缓冲区，格式化为单行记录后批量写入文件并按大小轮转
+class asyncLogger {
+public:
+    static asyncLogger& getInstance() {
+        static asyncLogger instance;
+        return instance;
+    }
+
+    // 启动时调用，运行中可再次调用以热加载：级别与采样比例立即生效，
+    // 格式、文件路径与轮转参数由后台线程在下一个写盘周期切换，ring_size 只影响新线程
+    void configure(const LogOptions& options) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool reopen = options.file != options_.file;
+        options_ = options;
+        if (options.level == "off") {
+            level_.store(LEVEL_OFF, std::memory_order_relaxed);
+        } else if (options.level == "error") {
+            level_.store(LEVEL_ERROR, std::memory_order_relaxed);
+        } else {
+            level_.store(LEVEL_INFO, std::memory_order_relaxed);
+        }
+        double rate = std::min(1.0, std::max(0.0, options.sample_rate));
+        sample_threshold_.store(static_cast<uint64_t>(rate * 4294967296.0), std::memory_order_relaxed);
+
+        std::size_t ring_size = 1;
+        while (ring_size < static_cast<std::size_t>(std::max(2, options.ring_size))) {
+            ring_size <<= 1;
+        }
+        ring_size_ = ring_size;
+
+        if (writer_.joinable()) {
+            reopen_ = reopen_ || reopen;
+            return;
+        }
+        // 后台线程启动前由调用方打开文件，之后文件只由后台线程访问
+        active_ = options_;
+        json_ = active_.format != "kv";
+        if (!openFile()) {
+            level_.store(LEVEL_OFF, std::memory_order_relaxed);
+            return;
+        }
+        writer_ = std::thread([this]() { writerLoop(); });
+    }
+
+    // 快速判断本次请求是否需要记录：级别过滤 + 成功请求按比例采样
+    bool shouldLog(bool success) {
+        int level = level_.load(std::memory_order_relaxed);
+        if (level == LEVEL_OFF) {
+            return false;
+        }
+        if (success) {
+            if (level < LEVEL_INFO) {
+                return false;
+            }
+            uint64_t threshold = sample_threshold_.load(std::memory_order_relaxed);
+            if (threshold < 4294967296ULL && (nextRandom() & 0xffffffffULL) >= threshold) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void log(LogOp op, bool success, const std::string& name, int age, 
+             int64_t count, const char* message, std::size_t message_len) {
+        append(op, success, name, message, message_len, [age, count](LogRecord& record) {
+            record.age = age;
+            record.count = count;
+        });
+    }
+
+    void log(LogOp op, bool success, const std::string& name, int age, 
+             int64_t count, const std::string& message) {
+        log(op, success, name, age, count, message.data(), message.size());
+    }
+
+    void log(LogOp op, bool success, const std::string& name, int age, 
+             int64_t count, const char* message) {
+        log(op, success, name, age, count, message, std::strlen(message));
+    }
+
+    // 批量操作：mode 为 ATOMIC 或 BEST_EFFORT
+    void logBatch(bool success, const std::string& mode, int64_t succeeded, int64_t total,
+                  const std::string& message) {
+        append(LogOp::Batch, success, mode, message.data(), message.size(),
+               [succeeded, total](LogRecord& record) {
+            record.count = succeeded;
+            record.total = total;
+        });
+    }
+
+    // 流式查询：max_age <= 0 表示不限上界
+    void logQuery(bool success, const std::string& prefix, int min_age, int max_age, int64_t rows,
+                  const std::string& message) {
+        append(LogOp::Query, success, prefix, message.data(), message.size(),
+               [min_age, max_age, rows](LogRecord& record) {
+            record.age = min_age;
+            record.max_age = max_age;
+            record.count = rows;
+        });
+    }
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    ~asyncLogger() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+private:
+    enum { LEVEL_OFF = 0, LEVEL_ERROR = 1, LEVEL_INFO = 2 };
+
+    struct Ring {
+        explicit Ring(std::size_t size) : slots(size) {}
+        std::vector<LogRecord> slots;
+        alignas(64) std::atomic<std::size_t> head{0};  // 生产者（请求线程）写入位置
+        alignas(64) std::atomic<std::size_t> tail{0};  // 消费者（后台线程）读取位置
+    };
+
+    asyncLogger() = default;
+
+    Ring* localRing() {
+        thread_local std::shared_ptr<Ring> ring;
+        if (!ring) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_ || ring_size_ == 0) {
+                return nullptr;
+            }
+            ring = std::make_shared<Ring>(ring_size_);
+            rings_.push_back(ring);
+        }
+        return ring.get();
+    }
+
+    // 在本线程的环形缓冲区中写入一条记录，op 相关的数值字段由 fill 填写
+    template <typename Fill>
+    void append(LogOp op, bool success, const std::string& name, 
+                const char* message, std::size_t message_len, Fill&& fill) {
+        if (!shouldLog(success)) {
+            return;
+        }
+        Ring* ring = localRing();
+        if (!ring) {
+            return;
+        }
+
+        std::size_t head = ring->head.load(std::memory_order_relaxed);
+        std::size_t tail = ring->tail.load(std::memory_order_acquire);
+        if (head - tail >= ring->slots.size()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        LogRecord& record = ring->slots[head & (ring->slots.size() - 1)];
+        record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.count = 0;
+        record.total = 0;
+        record.age = 0;
+        record.max_age = 0;
+        fill(record);
+        record.op = op;
+        record.success = success;
+        record.name_len = static_cast<uint8_t>(truncateUtf8(name.data(), name.size(), sizeof(record.name)));
+        std::memcpy(record.name, name.data(), record.name_len);
+        record.message_len = static_cast<uint8_t>(truncateUtf8(message, message_len, sizeof(record.message)));
+        std::memcpy(record.message, message, record.message_len);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    // 截断到不超过 max_len 的完整 UTF-8 字符边界
+    static std::size_t truncateUtf8(const char* data, std::size_t len, std::size_t max_len) {
+        if (len <= max_len) {
+            return len;
+        }
+        std::size_t cut = max_len;
+        while (cut > 0 && (static_cast<unsigned char>(data[cut]) & 0xC0) == 0x80) {
+            --cut;
+        }
+        return cut;
+    }
+
+    static uint64_t nextRandom() {
+        thread_local uint64_t state = 
+            reinterpret_cast<uintptr_t>(&state) ^ 0x9e3779b97f4a7c15ULL;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    bool openFile() {
+        if (file_) {
+            std::fclose(file_);
+        }
+        file_ = std::fopen(active_.file.c_str(), "a");
+        if (!file_) {
+            std::cerr << "日志文件打开失败: " << active_.file << std::endl;
+            return false;
+        }
+        std::fseek(file_, 0, SEEK_END);
+        file_size_ = std::ftell(file_);
+        return true;
+    }
+
+    void rotate() {
+        std::fclose(file_);
+        file_ = nullptr;
+        for (int i = active_.max_files - 1; i >= 1; --i) {
+            std::string from = active_.file + "." + std::to_string(i);
+            std::string to = active_.file + "." + std::to_string(i + 1);
+            std::rename(from.c_str(), to.c_str());
+        }
+        if (active_.max_files > 0) {
+            std::rename(active_.file.c_str(), (active_.file + ".1").c_str());
+        } else {
+            std::remove(active_.file.c_str());
+        }
+        openFile();
+    }
+
+    void writerLoop() {
+        std::string buffer;
+        buffer.reserve(1 << 16);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait_for(lock, std::chrono::milliseconds(std::max(1, active_.flush_interval_ms)),
+                           [this]() { return stop_; });
+            bool stopping = stop_;
+            std::vector<std::shared_ptr<Ring>> rings = rings_;
+            // 取走热加载的新参数，之后的格式化与写盘只读 active_
+            active_ = options_;
+            json_ = active_.format != "kv";
+            bool reopen = reopen_;
+            reopen_ = false;
+            lock.unlock();
+
+            if (reopen) {
+                openFile();
+            }
+
+            for (auto& ring : rings) {
+                drain(*ring, buffer);
+            }
+            uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                buffer += json_ ? "{\"op\":\"LOGGER\",\"dropped\":" + std::to_string(dropped) + "}\n"
+                                : "op=LOGGER dropped=" + std::to_string(dropped) + "\n";
+            }
+            write(buffer);
+            buffer.clear();
+
+            lock.lock();
+            // 线程已退出且已排空的缓冲区在此回收
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), 
+                [](const std::shared_ptr<Ring>& ring) {
+                    return ring.use_count() == 1 &&
+                           ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed);
+                }), rings_.end());
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    void drain(Ring& ring, std::string& buffer) {
+        std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+        std::size_t head = ring.head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            format(ring.slots[tail & (ring.slots.size() - 1)], buffer);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+
+    void write(const std::string& buffer) {
+        if (buffer.empty() || !file_) {
+            return;
+        }
+        std::fwrite(buffer.data(), 1, buffer.size(), file_);
+        std::fflush(file_);
+        file_size_ += static_cast<long>(buffer.size());
+        if (active_.max_file_mb > 0 && file_size_ >= static_cast<long>(active_.max_file_mb) * 1024 * 1024) {
+            rotate();
+        }
+    }
+
+    static const char* opName(LogOp op) {
+        switch (op) {
+            case LogOp::Insert: return "INSERT";
+            case LogOp::Update: return "UPDATE";
+            case LogOp::Delete: return "DELETE";
+            case LogOp::Batch: return "BATCH";
+            case LogOp::Query: return "QUERY";
+            case LogOp::GetUser: return "GETUSER";
+        }
+        return "UNKNOWN";
+    }
+
+    static void appendEscaped(std::string& buffer, const char* data, std::size_t len) {
+        for (std::size_t i = 0; i < len; ++i) {
+            char c = data[i];
+            if (c == '"' || c == '\\') {
+                buffer += '\\';
+                buffer += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer += escaped;
+            } else {
+                buffer += c;
+            }
+        }
+    }
+
+    // 按 op 输出各字段：json 为 ,"key":value，kv 为  key=value
+    static void appendField(std::string& buffer, bool json, const char* key) {
+        buffer += json ? ",\"" : " ";
+        buffer += key;
+        buffer += json ? "\":" : "=";
+    }
+
+    static void appendText(std::string& buffer, bool json, const char* key, const LogRecord& record) {
+        appendField(buffer, json, key);
+        buffer += '"';
+        appendEscaped(buffer, record.name, record.name_len);
+        buffer += '"';
+    }
+
+    static void appendNumber(std::string& buffer, bool json, const char* key, int64_t value) {
+        appendField(buffer, json, key);
+        buffer += std::to_string(value);
+    }
+
+    static void appendFields(const LogRecord& record, std::string& buffer, bool json) {
+        switch (record.op) {
+            case LogOp::Batch:
+                appendText(buffer, json, "mode", record);
+                appendNumber(buffer, json, "succeeded", record.count);
+                appendNumber(buffer, json, "total", record.total);
+                break;
+            case LogOp::Query:
+                appendText(buffer, json, "prefix", record);
+                appendNumber(buffer, json, "min_age", record.age);
+                appendNumber(buffer, json, "max_age", record.max_age);
+                appendNumber(buffer, json, "rows", record.count);
+                break;
+            default:
+                appendText(buffer, json, "name", record);
+                appendNumber(buffer, json, "age", record.age);
+                appendNumber(buffer, json, "count", record.count);
+                break;
+        }
+    }
+
+    void format(const LogRecord& record, std::string& buffer) {
+        std::time_t seconds = static_cast<std::time_t>(record.timestamp_us / 1000000);
+        std::tm tm_utc;
+        gmtime_r(&seconds, &tm_utc);
+        char ts[40];
+        std::size_t ts_len = std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm_utc);
+        std::snprintf(ts + ts_len, sizeof(ts) - ts_len, ".%06dZ", 
+                      static_cast<int>(record.timestamp_us % 1000000));
+
+        if (json_) {
+            buffer += "{\"ts\":\"";
+            buffer += ts;
+            buffer += "\",\"op\":\"";
+            buffer += opName(record.op);
+            buffer += "\",\"ok\":";
+            buffer += record.success ? "true" : "false";
+            appendFields(record, buffer, true);
+            buffer += ",\"msg\":\"";
+            appendEscaped(buffer, record.message, record.message_len);
+            buffer += "\"}\n";
+        } else {
+            buffer += "ts=";
+            buffer += ts;
+            buffer += " op=";
+            buffer += opName(record.op);
+            buffer += " ok=";
+            buffer += record.success ? "1" : "0";
+            appendFields(record, buffer, false);
+            buffer += " msg=\"";
+            appendEscaped(buffer, record.message, record.message_len);
+            buffer += "\"\n";
+        }
+    }
+
+    LogOptions options_;   // 最近一次 configure 的参数，受 mutex_ 保护
+    LogOptions active_;    // 后台线程正在使用的参数，只由后台线程读写
+    bool json_ = true;
+    bool reopen_ = false;  // 文件路径已变更，后台线程需重新打开
+    std::atomic<int> level_{LEVEL_OFF};
+    std::atomic<uint64_t> sample_threshold_{4294967296ULL};
+    std::atomic<uint64_t> dropped_{0};
+    std::size_t ring_size_ = 0;
+
+    std::FILE* file_ = nullptr;
+    long file_size_ = 0;
+
+    bool stop_ = false;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread writer_;
+};
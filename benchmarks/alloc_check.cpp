@@ -0,0 +1,148 @@
+#include "checkFixture.h"
+#include "dbService.h"
+#include "arenaAllocator.h"
+#include "asyncLogger.h"
+#include "slowLog.h"
+#include "mgrMysql.pb.h"
+#include <grpcpp/test/default_reactor_test_peer.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+// 写请求成功路径的堆分配计数：直接调用异步服务 DBAsyncServiceImpl::ExecuteOperation，
+// 请求与应答分配在 arenaMessageAllocator 的 arena 上，服务把调用状态放到同一 arena 上交给执行器，
+// 在请求作用域内经 mysqlMgr（接入替身驱动）写入、填充应答、记日志、结束追踪并按抽样写入慢请求日志，
+// 再由默认 reactor 结束调用。gRPC 的 DefaultReactorTestPeer 让调用不经过网络直接结束，
+// 预热后统计请求经过的线程（调用线程与执行器线程）上 operator new 的次数，不为 0 时返回非零退出码。
+// 日志与慢请求日志的后台线程按批次攒写缓冲，不随请求分配，不在统计范围内；
+// gRPC 核心收发消息的分配与 Connector/C++ 驱动内部的分配同样不在统计范围内（驱动由 fakeDriver.h 替代）
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocations{0};
+thread_local bool requestThread = false;
+
+void* countedAlloc(std::size_t size) {
+    if (requestThread && counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// 一次请求，返回是否成功。context 在各次请求间复用，finished 由默认 reactor 的 Finish 置位
+bool runOnce(DBAsyncServiceImpl& service, grpc::CallbackServerContext& context,
+             arenaMessageAllocator<DBRequest, DBResponse>& allocator, std::atomic<bool>& finished,
+             const std::string& wire, char* out, std::size_t out_size) {
+    grpc::MessageHolder<DBRequest, DBResponse>* holder = allocator.AllocateMessages();
+    if (!holder->request()->ParseFromArray(wire.data(), static_cast<int>(wire.size()))) {
+        holder->Release();
+        return false;
+    }
+
+    finished.store(false, std::memory_order_relaxed);
+    service.ExecuteOperation(&context, holder->request(), holder->response());
+    while (!finished.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    bool ok = holder->response()->success() &&
+              holder->response()->SerializeToArray(out, static_cast<int>(out_size));
+    holder->Release();
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    const int warmup = 2000;
+    const int iterations = 20000;
+
+    LogOptions log;
+    log.file = "alloc_check.log";
+    asyncLogger::getInstance().configure(log);
+
+    // 抽样一部分请求写入慢请求日志，覆盖入队路径
+    TraceOptions trace;
+    trace.file = "alloc_check_slow.log";
+    trace.sample_rate = 0.01;
+    slowLog::getInstance().configure(trace);
+
+    // 其余取默认配置（缓存与并发限制开启）；单个执行器线程，预热时即被标记为请求线程
+    PoolOptions pool = fakeDatabase::singleConnection();
+    pool.min_conn_num = 4;
+    pool.max_conn_num = 4;
+    fakeDatabase db(pool);
+    ServerConfig config;
+    config.grpc.executor_threads = 1;
+    DBAsyncServiceImpl service(config, db.release());
+    arenaMessageAllocator<DBRequest, DBResponse> allocator;
+
+    std::atomic<bool> finished{false};
+    std::atomic<bool> all_ok{true};
+    grpc::CallbackServerContext context;
+    grpc::testing::DefaultReactorTestPeer peer(&context, [&finished, &all_ok](grpc::Status status) {
+        requestThread = true;
+        if (!status.ok()) {
+            all_ok.store(false, std::memory_order_relaxed);
+        }
+        finished.store(true, std::memory_order_release);
+    });
+
+    DBRequest request;
+    request.set_operation(DBRequest::INSERT);
+    request.mutable_user_info()->set_name("alice");
+    request.mutable_user_info()->set_age(30);
+    std::string wire = request.SerializeAsString();
+    char out[256];
+
+    for (int i = 0; i < warmup; ++i) {
+        if (!runOnce(service, context, allocator, finished, wire, out, sizeof(out)) || !all_ok.load()) {
+            std::fprintf(stderr, "预热请求失败\n");
+            return 1;
+        }
+    }
+
+    requestThread = true;
+    counting.store(true);
+    for (int i = 0; i < iterations; ++i) {
+        if (!runOnce(service, context, allocator, finished, wire, out, sizeof(out))) {
+            counting.store(false);
+            std::fprintf(stderr, "请求失败\n");
+            return 1;
+        }
+    }
+    counting.store(false);
+
+    uint64_t total = allocations.load();
+    std::printf("%d 次请求, 堆分配 %llu 次 (每次请求 %.3f)\n", iterations,
+                static_cast<unsigned long long>(total), static_cast<double>(total) / iterations);
+    expect(all_ok.load(), "全部请求以 OK 结束");
+    expect(total == 0, "稳定状态下请求线程上没有堆分配");
+    return checkResult();
+}
@@ -0,0 +1,131 @@
+#include "checkFixture.h"
+#include "requestScope.h"
+#include "writeBehind.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+// 熔断器的端到端检查：替身驱动模拟数据库宕机后，连续的连接类错误使熔断器断开；
+// 断开期间请求直接被拒绝并标记为不可用，不再触达驱动；后台探测按指数退避进行；
+// 延迟写回的写入在断开期间照常确认但暂停写回，日志写满后立即拒绝；
+// 数据库恢复后探测成功转为半开，试探请求成功后闭合
+
+int main() {
+    PoolOptions pool = fakeDatabase::singleConnection();
+    pool.min_conn_num = 2;
+    pool.max_conn_num = 4;
+    BreakerOptions breaker;
+    breaker.consecutive_failures = 3;
+    breaker.open_ms = 50;
+    breaker.max_open_ms = 400;
+    breaker.half_open_requests = 2;
+    fakeDatabase db(pool, breaker);
+    FakeOptions& fake = db.fake;
+    mysqlMgr& mgr = *db.mgr;
+    const circuitBreaker& state = mgr.breaker();
+
+    expect(mgr.insert("alice", 30), "数据库正常时写入成功");
+
+    // 数据库宕机：借出的连接执行失败，之后扩容建连失败
+    fake.reachable = false;
+    int attempts = 0;
+    while (!state.isOpen() && attempts < 10) {
+        mgr.insert("alice", 30);
+        ++attempts;
+    }
+    expect(state.isOpen() && attempts <= breaker.consecutive_failures, "连续连接类错误后熔断器断开");
+    expect(!mgr.writable() && !mgr.readable(), "断开后主库不可写、不可读");
+
+    // 后台探测：第 k 次失败后的等待在 [b/2, b] 内，b = open_ms * 2^k，上限 max_open_ms。
+    // 每次失败都会推后 nextProbe，按相邻两次的间隔与刚推后时的 retryAfter 断言，不依赖墙钟计数。
+    // 断开后立即取首次探测时间，首次探测最早在 open_ms/2 之后
+    circuitBreaker::Clock::time_point previous = state.nextProbe();
+    expect(state.retryAfter() <= std::chrono::milliseconds(breaker.open_ms), "首次探测在 open_ms 内");
+    int backoff = breaker.open_ms;
+    bool backoff_ok = true;
+    for (int probe = 1; probe <= 4 && backoff_ok; ++probe) {
+        backoff = std::min(breaker.max_open_ms, backoff * 2);
+        if (!waitFor([&]() { return state.nextProbe() != previous; })) {
+            backoff_ok = false;
+            break;
+        }
+        circuitBreaker::Clock::time_point next = state.nextProbe();
+        std::chrono::milliseconds retry_after = state.retryAfter();
+        std::printf("第 %d 次探测失败, 退避上限 %dms, 下次探测在 %lldms 后\n", probe, backoff,
+                    static_cast<long long>(retry_after.count()));
+        backoff_ok = retry_after <= std::chrono::milliseconds(backoff) &&
+                     next - previous >= std::chrono::milliseconds(backoff / 2);
+        previous = next;
+    }
+    expect(backoff_ok, "后台探测按带抖动的指数退避进行");
+    expect(state.isOpen() && state.opened() == 1, "探测失败时保持断开");
+
+    // 断开期间的请求：不借连接、不建连、不产生往返
+    uint64_t round_trips = fake.round_trips.load();
+    uint64_t rejected = state.rejected();
+    bool all_unavailable = true;
+    for (int i = 0; i < 1000; ++i) {
+        requestScope scope(requestScope::Clock::time_point::max(), nullptr);
+        if (mgr.insert("alice", 30) || !scope.unavailable()) {
+            all_unavailable = false;
+        }
+    }
+    expect(all_unavailable, "断开期间请求直接失败并标记为不可用");
+    expect(fake.round_trips.load() == round_trips, "断开期间请求不触达驱动");
+    expect(state.rejected() - rejected == 1000, "拒绝计数");
+
+    // 延迟写回：断开期间写入照常落盘确认，写回线程等到下一次探测之后再试，不把批次交给熔断器；
+    // 积压无法写回，日志写满后新的写入立即被拒绝，不等待 backpressure_wait_ms
+    {
+        const std::string dir = "breaker_check_wal";
+        std::filesystem::remove_all(dir);
+        WriteBehindOptions options;
+        options.dir = dir;
+        options.segment_mb = 1;
+        options.max_log_mb = 2;
+        options.backpressure_wait_ms = 60000;
+        std::atomic<int> durable{0};
+        writeBehindLog log(mgr, options, nullptr);
+        auto submit = [&]() {
+            return log.submit(BatchOp{BatchOp::Type::Insert, "alice", 30}, [&durable](bool synced) {
+                if (synced) {
+                    durable.fetch_add(1);
+                }
+            });
+        };
+
+        rejected = state.rejected();
+        int accepted = 0;
+        while (accepted < 3 && submit()) {
+            ++accepted;
+        }
+        expect(accepted == 3 && waitFor([&]() { return durable.load() == 3; }), "断开期间延迟写回的写入照常确认");
+        expect(waitFor([&]() { return log.stats().apply_retries >= 2; }), "写回线程等到下一次探测之后再试");
+        expect(state.rejected() == rejected && log.stats().applied_lsn == 0, "断开期间写回不触达熔断器");
+
+        auto filling = std::chrono::steady_clock::now();
+        while (accepted < (1 << 20) && submit()) {
+            ++accepted;
+        }
+        expect(log.stats().rejected == 1 &&
+               std::chrono::steady_clock::now() - filling < std::chrono::milliseconds(options.backpressure_wait_ms),
+               "日志写满后立即拒绝, 不等待腾出空间");
+        expect(log.stats().backlog == static_cast<uint64_t>(accepted), "已确认的写入全部保留在日志中");
+    }
+    std::filesystem::remove_all("breaker_check_wal");
+
+    // 数据库恢复：探测成功转为半开，试探请求成功后闭合
+    fake.reachable = true;
+    expect(waitFor([&]() { return !state.isOpen(); }, std::chrono::seconds(2)), "恢复后探测成功转为半开");
+    bool recovered = true;
+    for (int i = 0; i < breaker.half_open_requests; ++i) {
+        recovered = mgr.insert("alice", 30) && recovered;
+    }
+    expect(recovered && state.state() == circuitBreaker::State::Closed, "试探请求成功后闭合");
+    expect(mgr.insert("alice", 30), "闭合后写入成功");
+
+    return checkResult();
+}
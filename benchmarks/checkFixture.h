@@ -0,0 +1,68 @@
+#pragma once
+#include "fakeDriver.h"
+#include "mysqlMgr.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+// 各检查程序共用的断言与替身数据库：expect 打印每项检查的结果并累计失败数，
+// checkResult 作为 main 的返回值；waitFor 轮询等待条件成立，代替固定时长的 sleep；
+// fakeDatabase 是接入 fakeDriver 的单主库 mysqlMgr
+
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void expect(bool condition, const char* what) {
+    std::printf("%-44s %s\n", what, condition ? "通过" : "失败");
+    if (!condition) {
+        ++checkFailures();
+    }
+}
+
+inline int checkResult() {
+    return checkFailures() == 0 ? 0 : 1;
+}
+
+// 条件在 timeout 内成立时返回 true
+template <typename Pred>
+bool waitFor(Pred pred, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// 替身驱动上的主库与 mysqlMgr。默认一个连接、关闭空闲校验，使往返计数只来自被测的调用；
+// fake 必须比连接池活得久，因此放在 mgr 之前
+struct fakeDatabase {
+    static PoolOptions singleConnection() {
+        PoolOptions pool;
+        pool.min_conn_num = 1;
+        pool.max_conn_num = 1;
+        pool.validate_idle_sec = -1;
+        return pool;
+    }
+
+    explicit fakeDatabase(const PoolOptions& pool = singleConnection(),
+                          const BreakerOptions& breaker = BreakerOptions()) {
+        auto dao = std::make_unique<mysqlDao>(fakeConnectionFactory(fake), "fake", pool, breaker);
+        primary = dao.get();
+        mgr = std::make_unique<mysqlMgr>(std::move(dao));
+    }
+
+    // 交出 mysqlMgr（如注入服务）；primary 与 fake 仍可继续使用，本对象须比接收方活得久
+    std::unique_ptr<mysqlMgr> release() {
+        return std::move(mgr);
+    }
+
+    FakeOptions fake;
+    mysqlDao* primary = nullptr;
+    std::unique_ptr<mysqlMgr> mgr;
+};
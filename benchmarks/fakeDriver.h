@@ -0,0 +1,321 @@
+#pragma once
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+// 进程内的 sql::Connection 替身，用于在没有 MySQL 的机器上对连接池与 DAO 层做基准测试。
+// 只实现 mysqlDao/mysqlMgr 用到的调用，其余接口抛出 MethodNotImplementedException；
+// 按 Connector/C++ 8.0 的 JDBC 兼容接口编写
+struct FakeOptions {
+    int connect_latency_us = 0;   // 建连
+    int ping_latency_us = 0;      // isValid / SELECT 1
+    int execute_latency_us = 0;   // 每次 execute/executeUpdate/executeQuery
+    int commit_latency_us = 0;    // commit / rollback
+    int result_rows = 1;          // executeQuery 返回的行数
+    std::atomic<bool> healthy{true};  // 置为 false 时 isValid 返回 false
+    std::atomic<bool> reachable{true};  // 置为 false 模拟数据库宕机：建连与每次往返抛出连接类错误
+    std::atomic<uint64_t> connect_attempts{0};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> round_trips{0};      // 驱动层实际发生的往返，含 setAutoCommit
+    std::atomic<uint64_t> autocommit_changes{0};
+    std::atomic<uint64_t> updated_rows{0};     // executeUpdate 成功写入的行数累计
+};
+
+namespace fake {
+
+inline void simulate(int latency_us) {
+    if (latency_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+    }
+}
+
+inline void roundTrip(FakeOptions& options, int latency_us) {
+    options.round_trips.fetch_add(1, std::memory_order_relaxed);
+    if (!options.reachable.load(std::memory_order_relaxed)) {
+        throw sql::SQLException("Lost connection to MySQL server during query", "HY000", 2013);
+    }
+    simulate(latency_us);
+}
+
+// executeUpdate 报告的受影响行数：多行 INSERT 为 VALUES 之后的行数，其余语句为 1
+inline int affectedRows(const std::string& sql) {
+    std::size_t values = sql.find("VALUES");
+    if (values == std::string::npos) {
+        return 1;
+    }
+    int rows = 0;
+    for (std::size_t i = values; i < sql.size(); ++i) {
+        rows += sql[i] == '(';
+    }
+    return std::max(1, rows);
+}
+
+[[noreturn]] inline void notImplemented(const char* method) {
+    throw sql::MethodNotImplementedException(method);
+}
+
+class ResultSet : public sql::ResultSet {
+public:
+    explicit ResultSet(int rows) : rows_(rows) {}
+
+    bool next() override { return ++row_ <= rows_; }
+    int32_t getInt(uint32_t columnIndex) const override { return static_cast<int32_t>(row_ + columnIndex); }
+    int64_t getInt64(uint32_t columnIndex) const override { return row_ + columnIndex; }
+    sql::SQLString getString(uint32_t /*columnIndex*/) const override { return "user_" + std::to_string(row_); }
+    size_t rowsCount() const override { return static_cast<size_t>(rows_); }
+    size_t getRow() const override { return static_cast<size_t>(row_); }
+    bool isClosed() const override { return false; }
+    void close() override {}
+
+    bool absolute(int) override { notImplemented("absolute"); }
+    void afterLast() override { notImplemented("afterLast"); }
+    void beforeFirst() override { row_ = 0; }
+    void cancelRowUpdates() override { notImplemented("cancelRowUpdates"); }
+    void clearWarnings() override {}
+    uint32_t findColumn(const sql::SQLString&) const override { notImplemented("findColumn"); }
+    bool first() override { notImplemented("first"); }
+    std::istream* getBlob(uint32_t) const override { notImplemented("getBlob"); }
+    std::istream* getBlob(const sql::SQLString&) const override { notImplemented("getBlob"); }
+    bool getBoolean(uint32_t) const override { notImplemented("getBoolean"); }
+    bool getBoolean(const sql::SQLString&) const override { notImplemented("getBoolean"); }
+    int getConcurrency() override { return CONCUR_READ_ONLY; }
+    sql::SQLString getCursorName() override { notImplemented("getCursorName"); }
+    long double getDouble(uint32_t) const override { notImplemented("getDouble"); }
+    long double getDouble(const sql::SQLString&) const override { notImplemented("getDouble"); }
+    int getFetchDirection() override { return FETCH_FORWARD; }
+    size_t getFetchSize() override { return 0; }
+    int getHoldability() override { return CLOSE_CURSORS_AT_COMMIT; }
+    int32_t getInt(const sql::SQLString&) const override { notImplemented("getInt"); }
+    uint32_t getUInt(uint32_t) const override { notImplemented("getUInt"); }
+    uint32_t getUInt(const sql::SQLString&) const override { notImplemented("getUInt"); }
+    int64_t getInt64(const sql::SQLString&) const override { notImplemented("getInt64"); }
+    uint64_t getUInt64(uint32_t) const override { notImplemented("getUInt64"); }
+    uint64_t getUInt64(const sql::SQLString&) const override { notImplemented("getUInt64"); }
+    sql::ResultSetMetaData* getMetaData() const override { notImplemented("getMetaData"); }
+    sql::RowID* getRowId(uint32_t) override { notImplemented("getRowId"); }
+    sql::RowID* getRowId(const sql::SQLString&) override { notImplemented("getRowId"); }
+    const sql::Statement* getStatement() const override { return nullptr; }
+    sql::SQLString getString(const sql::SQLString&) const override { notImplemented("getString"); }
+    enum_type getType() const override { return TYPE_FORWARD_ONLY; }
+    void getWarnings() override {}
+    void insertRow() override { notImplemented("insertRow"); }
+    bool isAfterLast() const override { return row_ > rows_; }
+    bool isBeforeFirst() const override { return row_ == 0; }
+    bool isFirst() const override { return row_ == 1; }
+    bool isLast() const override { return row_ == rows_; }
+    bool isNull(uint32_t) const override { return false; }
+    bool isNull(const sql::SQLString&) const override { return false; }
+    bool last() override { notImplemented("last"); }
+    void moveToCurrentRow() override { notImplemented("moveToCurrentRow"); }
+    void moveToInsertRow() override { notImplemented("moveToInsertRow"); }
+    bool previous() override { notImplemented("previous"); }
+    void refreshRow() override { notImplemented("refreshRow"); }
+    bool relative(int) override { notImplemented("relative"); }
+    bool rowDeleted() override { return false; }
+    bool rowInserted() override { return false; }
+    bool rowUpdated() override { return false; }
+    void setFetchSize(size_t) override {}
+    bool wasNull() const override { return false; }
+
+private:
+    int rows_;
+    int row_ = 0;
+};
+
+// Statement 与 PreparedStatement 共用的行为：每次执行模拟一次往返，
+// execute 之后 getResultSet 交出一个结果集，供 QueryGuard 清理
+template <typename Base>
+class StatementBase : public Base {
+public:
+    explicit StatementBase(FakeOptions& options, int rows = 1) : options_(options), rows_(rows) {}
+
+    sql::Connection* getConnection() override { return nullptr; }
+    void cancel() override {}
+    void clearWarnings() override {}
+    void close() override {}
+    bool execute(const sql::SQLString&) override { return runExecute(); }
+    sql::ResultSet* executeQuery(const sql::SQLString&) override { return runQuery(); }
+    int executeUpdate(const sql::SQLString& sql) override {
+        rows_ = affectedRows(sql.asStdString());
+        return runUpdate();
+    }
+    size_t getFetchSize() override { return 0; }
+    unsigned int getMaxFieldSize() override { return 0; }
+    uint64_t getMaxRows() override { return 0; }
+    bool getMoreResults() override {
+        // 模拟存储过程返回的多个结果集：execute 后还有 pending_results_ - 1 个
+        if (pending_results_ > 0) {
+            --pending_results_;
+        }
+        return pending_results_ > 0;
+    }
+    unsigned int getQueryTimeout() override { return 0; }
+    sql::ResultSet* getResultSet() override {
+        return pending_results_ > 0 ? new ResultSet(options_.result_rows) : nullptr;
+    }
+    sql::ResultSet::enum_type getResultSetType() override { return sql::ResultSet::TYPE_FORWARD_ONLY; }
+    uint64_t getUpdateCount() override { return static_cast<uint64_t>(rows_); }
+    const sql::SQLWarning* getWarnings() override { return nullptr; }
+    void setCursorName(const sql::SQLString&) override {}
+    void setEscapeProcessing(bool) override {}
+    void setFetchSize(size_t) override {}
+    void setMaxFieldSize(unsigned int) override {}
+    void setMaxRows(unsigned int) override {}
+    void setQueryTimeout(unsigned int) override {}
+    int setQueryAttrBigInt(const sql::SQLString&, const sql::SQLString&) override { return 0; }
+    int setQueryAttrBoolean(const sql::SQLString&, bool) override { return 0; }
+    int setQueryAttrDateTime(const sql::SQLString&, const sql::SQLString&) override { return 0; }
+    int setQueryAttrDouble(const sql::SQLString&, double) override { return 0; }
+    int setQueryAttrInt(const sql::SQLString&, int32_t) override { return 0; }
+    int setQueryAttrUInt(const sql::SQLString&, uint32_t) override { return 0; }
+    int setQueryAttrInt64(const sql::SQLString&, int64_t) override { return 0; }
+    int setQueryAttrUInt64(const sql::SQLString&, uint64_t) override { return 0; }
+    int setQueryAttrNull(const sql::SQLString&) override { return 0; }
+    int setQueryAttrString(const sql::SQLString&, const sql::SQLString&) override { return 0; }
+    void clearAttributes() override {}
+
+    // 基准测试设置的结果集个数，供 QueryGuard 的清理路径使用
+    void setPendingResults(int count) {
+        pending_results_ = count;
+    }
+
+protected:
+    bool runExecute() {
+        roundTrip(options_, options_.execute_latency_us);
+        pending_results_ = 1;
+        return true;
+    }
+
+    sql::ResultSet* runQuery() {
+        roundTrip(options_, options_.execute_latency_us);
+        return new ResultSet(options_.result_rows);
+    }
+
+    int runUpdate() {
+        roundTrip(options_, options_.execute_latency_us);
+        options_.updated_rows.fetch_add(static_cast<uint64_t>(rows_), std::memory_order_relaxed);
+        return rows_;
+    }
+
+    FakeOptions& options_;
+    int rows_;
+    int pending_results_ = 0;
+};
+
+class Statement : public StatementBase<sql::Statement> {
+public:
+    using StatementBase::StatementBase;
+
+    sql::Statement* setResultSetType(sql::ResultSet::enum_type) override { return this; }
+};
+
+class PreparedStatement : public StatementBase<sql::PreparedStatement> {
+public:
+    using StatementBase::StatementBase;
+    using StatementBase::execute;
+    using StatementBase::executeQuery;
+    using StatementBase::executeUpdate;
+
+    void clearParameters() override {}
+    bool execute() override { return runExecute(); }
+    sql::ResultSet* executeQuery() override { return runQuery(); }
+    int executeUpdate() override { return runUpdate(); }
+    sql::ResultSetMetaData* getMetaData() override { notImplemented("getMetaData"); }
+    sql::ParameterMetaData* getParameterMetaData() override { notImplemented("getParameterMetaData"); }
+    void setBigInt(unsigned int, const sql::SQLString&) override {}
+    void setBlob(unsigned int, std::istream*) override {}
+    void setBoolean(unsigned int, bool) override {}
+    void setDateTime(unsigned int, const sql::SQLString&) override {}
+    void setDouble(unsigned int, double) override {}
+    void setInt(unsigned int, int32_t) override {}
+    void setUInt(unsigned int, uint32_t) override {}
+    void setInt64(unsigned int, int64_t) override {}
+    void setUInt64(unsigned int, uint64_t) override {}
+    void setNull(unsigned int, int) override {}
+    void setString(unsigned int, const sql::SQLString&) override {}
+    sql::PreparedStatement* setResultSetType(sql::ResultSet::enum_type) override { return this; }
+};
+
+class Connection : public sql::Connection {
+public:
+    explicit Connection(FakeOptions& options) : options_(options) {
+        options_.connect_attempts.fetch_add(1, std::memory_order_relaxed);
+        simulate(options_.connect_latency_us);
+        if (!options_.reachable.load(std::memory_order_relaxed)) {
+            throw sql::SQLException("Can't connect to MySQL server", "HY000", 2003);
+        }
+        options_.connects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    sql::Statement* createStatement() override { return new Statement(options_); }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql) override {
+        roundTrip(options_, options_.execute_latency_us);
+        return new PreparedStatement(options_, affectedRows(sql.asStdString()));
+    }
+    bool isValid() override {
+        roundTrip(options_, options_.ping_latency_us);
+        return options_.healthy.load(std::memory_order_relaxed);
+    }
+    void close() override { closed_ = true; }
+    bool isClosed() override { return closed_; }
+    void commit() override { roundTrip(options_, options_.commit_latency_us); }
+    void rollback() override { roundTrip(options_, options_.commit_latency_us); }
+    void setAutoCommit(bool autoCommit) override {
+        roundTrip(options_, 0);
+        options_.autocommit_changes.fetch_add(1, std::memory_order_relaxed);
+        auto_commit_ = autoCommit;
+    }
+    bool getAutoCommit() override { return auto_commit_; }
+    void setSchema(const sql::SQLString& schema) override { schema_ = schema; }
+    sql::SQLString getSchema() override { return schema_; }
+
+    void clearWarnings() override {}
+    sql::SQLString getCatalog() override { return schema_; }
+    sql::Driver* getDriver() override { return nullptr; }
+    sql::SQLString getClientInfo() override { return "fake"; }
+    void getClientOption(const sql::SQLString&, void*) override { notImplemented("getClientOption"); }
+    sql::SQLString getClientOption(const sql::SQLString&) override { notImplemented("getClientOption"); }
+    sql::DatabaseMetaData* getMetaData() override { notImplemented("getMetaData"); }
+    sql::enum_transaction_isolation getTransactionIsolation() override { return sql::TRANSACTION_REPEATABLE_READ; }
+    const sql::SQLWarning* getWarnings() override { return nullptr; }
+    bool isReadOnly() override { return false; }
+    bool reconnect() override { return true; }
+    sql::SQLString nativeSQL(const sql::SQLString& sql) override { return sql; }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql, int) override { return prepareStatement(sql); }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql, int*) override { return prepareStatement(sql); }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql, int, int) override { return prepareStatement(sql); }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql, int, int, int) override { return prepareStatement(sql); }
+    sql::PreparedStatement* prepareStatement(const sql::SQLString& sql, sql::SQLString[]) override { return prepareStatement(sql); }
+    void releaseSavepoint(sql::Savepoint*) override { notImplemented("releaseSavepoint"); }
+    void rollback(sql::Savepoint*) override { notImplemented("rollback"); }
+    void setCatalog(const sql::SQLString& catalog) override { schema_ = catalog; }
+    sql::Connection* setClientOption(const sql::SQLString&, const void*) override { return this; }
+    sql::Connection* setClientOption(const sql::SQLString&, const sql::SQLString&) override { return this; }
+    void setHoldability(int) override {}
+    void setReadOnly(bool) override {}
+    sql::Savepoint* setSavepoint() override { notImplemented("setSavepoint"); }
+    sql::Savepoint* setSavepoint(const sql::SQLString&) override { notImplemented("setSavepoint"); }
+    void setTransactionIsolation(sql::enum_transaction_isolation) override {}
+
+private:
+    FakeOptions& options_;
+    sql::SQLString schema_;
+    bool auto_commit_ = true;
+    bool closed_ = false;
+};
+
+}  // namespace fake
+
+// 供 mysqlDao 注入的连接工厂；options 必须比连接池活得久
+inline std::function<sql::Connection*()> fakeConnectionFactory(FakeOptions& options) {
+    return [&options]() -> sql::Connection* { return new fake::Connection(options); };
+}
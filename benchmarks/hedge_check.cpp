@@ -0,0 +1,110 @@
+#include "checkFixture.h"
+#include "dbClient.h"
+#include <grpcpp/grpcpp.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+// 客户端对冲读请求：本进程内的 gRPC 服务对名为 slow 的请求按需挂起，直到调用被取消。
+// 积累足够的延迟样本后，挂起的读请求触发对冲，对冲请求先返回，落后的原请求被取消；
+// 对冲定时器未触发时析构客户端，进行中的调用与定时器一起被取消，不会在已关闭的完成队列上发起对冲
+
+namespace {
+
+class hedgeService final : public db_operations::DBService::Service {
+public:
+    grpc::Status GetUser(grpc::ServerContext* context, const db_operations::GetUserRequest* request,
+                         db_operations::GetUserResponse* response) override {
+        if (request->name() == "slow") {
+            slow_requests.fetch_add(1);
+            int permits = stall_permits.load();
+            while (permits > 0 && !stall_permits.compare_exchange_weak(permits, permits - 1)) {
+            }
+            if (permits > 0) {
+                stalling.fetch_add(1);
+                waitFor([context]() { return context->IsCancelled(); });
+                if (!context->IsCancelled()) {
+                    return grpc::Status(grpc::StatusCode::ABORTED, "stall timed out");
+                }
+                cancelled.fetch_add(1);
+                return grpc::Status(grpc::StatusCode::CANCELLED, "cancelled while stalled");
+            }
+        }
+        response->set_found(true);
+        return grpc::Status::OK;
+    }
+
+    std::atomic<int> stall_permits{0};   // 接下来挂起的 slow 请求数
+    std::atomic<int> slow_requests{0};
+    std::atomic<int> stalling{0};
+    std::atomic<int> cancelled{0};       // 挂起期间被客户端取消的请求
+};
+
+// 积累一个完整的延迟窗口，使客户端启用对冲
+void warmUp(DBClient& client) {
+    for (int i = 0; i < 1000; ++i) {
+        client.GetUser("alice").get();
+    }
+}
+
+}  // namespace
+
+int main() {
+    hedgeService service;
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    if (!server || port == 0) {
+        std::printf("无法启动本地 gRPC 服务\n");
+        return 1;
+    }
+
+    ClientOptions options;
+    options.target = "127.0.0.1:" + std::to_string(port);
+    options.channels = 2;
+    options.cq_threads = 1;
+    options.deadline_ms = 0;
+
+    // 对冲生效：挂起的原请求超过对冲延迟后在另一个连接上重发，先返回的对冲请求生效，原请求被取消
+    {
+        DBClient client(options);
+        warmUp(client);
+        expect(client.stats().hedge_delay_us > 0, "积累样本后启用对冲");
+        service.stall_permits = 1;
+        CallResult<db_operations::GetUserResponse> result = client.GetUser("slow").get();
+        DBClient::Stats stats = client.stats();
+        expect(result.ok() && result.response.found(), "对冲请求返回的结果生效");
+        expect(stats.hedged == 1 && stats.hedge_wins == 1, "挂起的读请求触发一次对冲且对冲获胜");
+        expect(waitFor([&]() { return service.cancelled.load() == 1; }), "落后的原请求被取消");
+    }
+
+    // 对冲定时器未触发时析构：调用以 CANCELLED 结束，定时器不再发起对冲
+    {
+        ClientOptions slow_hedge = options;
+        slow_hedge.hedge_min_delay_us = 60 * 1000 * 1000;
+        auto client = std::make_unique<DBClient>(slow_hedge);
+        warmUp(*client);
+        service.stall_permits = 1;
+        int slow_before = service.slow_requests.load();
+        std::promise<grpc::Status> finished;
+        db_operations::GetUserRequest request;
+        request.set_name("slow");
+        client->GetUser(request, [&finished](const grpc::Status& status, db_operations::GetUserResponse&&) {
+            finished.set_value(status);
+        });
+        expect(waitFor([&]() { return service.stalling.load() == 2; }), "原请求在服务端挂起");
+        client.reset();
+        expect(finished.get_future().get().error_code() == grpc::StatusCode::CANCELLED, "析构时进行中的调用被取消");
+        expect(waitFor([&]() { return service.cancelled.load() == 2; }), "服务端看到调用被取消");
+        expect(service.slow_requests.load() - slow_before == 1, "析构后不再发起对冲请求");
+    }
+
+    server->Shutdown();
+    return checkResult();
+}
@@ -0,0 +1,139 @@
+#include "fakeDriver.h"
+#include "mysqlDao.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <mutex>
+
+// 连接池与 DAO 层的微基准，连接替换为 fakeDriver.h 的进程内替身，
+// 测得的是连接池自身的开销与锁竞争，不含网络与 MySQL 的执行时间
+
+namespace {
+
+// 多线程基准共享一个连接池：第 0 号线程在计时前创建，最后一个退出的线程销毁
+struct SharedPool {
+    FakeOptions fake;
+    std::unique_ptr<mysqlDao> dao;
+    std::mutex mutex;
+    int users = 0;
+
+    void acquire(const PoolOptions& options) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (users++ == 0) {
+            dao = std::make_unique<mysqlDao>(fakeConnectionFactory(fake), "fake", options);
+        }
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--users == 0) {
+            dao.reset();
+        }
+    }
+};
+
+PoolOptions benchmarkPoolOptions() {
+    PoolOptions options;
+    options.min_conn_num = 8;
+    options.max_conn_num = 8;
+    options.acquire_timeout_ms = 10000;
+    options.validate_idle_sec = -1;
+    return options;
+}
+
+// 借出与归还：range(0) 为空闲连接分片数，1 即单锁连接池；
+// 线程数超过连接数后本分片常为空，需要跨分片窃取或等待 conn_cond_
+void BM_AcquireRelease(benchmark::State& state) {
+    static SharedPool pool;
+    if (state.thread_index() == 0) {
+        pool.fake.execute_latency_us = 0;
+    }
+    PoolOptions options = benchmarkPoolOptions();
+    options.shards = static_cast<int>(state.range(0));
+    pool.acquire(options);
+    for (auto _ : state) {
+        auto conn = pool.dao->getConnection();
+        benchmark::DoNotOptimize(conn.get());
+        pool.dao->releaseConnection(std::move(conn));
+    }
+    pool.release();
+}
+BENCHMARK(BM_AcquireRelease)->Arg(1)->Arg(8)->ThreadRange(1, 64)->UseRealTime();
+
+// 完整的单语句事务：借出、START TRANSACTION、预处理（命中语句缓存）、执行、提交、归还；
+// range(0) 为模拟的单次往返微秒数
+void BM_ExecuteInTransaction(benchmark::State& state) {
+    static SharedPool pool;
+    if (state.thread_index() == 0) {
+        pool.fake.execute_latency_us = static_cast<int>(state.range(0));
+        pool.fake.commit_latency_us = static_cast<int>(state.range(0));
+    }
+    pool.acquire(benchmarkPoolOptions());
+    for (auto _ : state) {
+        bool ok = pool.dao->executeInTransaction([](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare("INSERT INTO test (name, age) VALUES (?, ?)");
+            pstmt->setString(1, "bench");
+            pstmt->setInt(2, 1);
+            return executeUpdate(pstmt) > 0;
+        });
+        benchmark::DoNotOptimize(ok);
+    }
+    pool.release();
+}
+BENCHMARK(BM_ExecuteInTransaction)->Arg(0)->Arg(50)->ThreadRange(1, 64)->UseRealTime();
+
+// 同一条语句在自动提交模式下执行：借出、预处理（命中语句缓存）、执行、归还，只有一次往返
+void BM_ExecuteAutocommit(benchmark::State& state) {
+    static SharedPool pool;
+    if (state.thread_index() == 0) {
+        pool.fake.execute_latency_us = static_cast<int>(state.range(0));
+    }
+    pool.acquire(benchmarkPoolOptions());
+    for (auto _ : state) {
+        bool ok = pool.dao->executeAutocommit([](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare("INSERT INTO test (name, age) VALUES (?, ?)");
+            pstmt->setString(1, "bench");
+            pstmt->setInt(2, 1);
+            return executeUpdate(pstmt) > 0;
+        });
+        benchmark::DoNotOptimize(ok);
+    }
+    pool.release();
+}
+BENCHMARK(BM_ExecuteAutocommit)->Arg(0)->Arg(50)->ThreadRange(1, 64)->UseRealTime();
+
+// QueryGuard 析构时逐个消费剩余结果集；range(0) 为结果集个数，range(1) 为每个结果集的行数
+void BM_QueryGuardTeardown(benchmark::State& state) {
+    FakeOptions fake;
+    fake.result_rows = static_cast<int>(state.range(1));
+    for (auto _ : state) {
+        auto stmt = std::make_unique<fake::Statement>(fake);
+        stmt->setPendingResults(static_cast<int>(state.range(0)));
+        mysqlDao::QueryGuard<fake::Statement> guard(std::move(stmt));
+        benchmark::DoNotOptimize(guard.get());
+    }
+}
+BENCHMARK(BM_QueryGuardTeardown)->Args({1, 1})->Args({1, 100})->Args({4, 100});
+
+// 保活与借出前校验对借出延迟的干扰：每次借出都需 ping（validate_idle_sec = 0），
+// 后台保活线程每秒在锁外逐个 ping 空闲连接；range(0) 为模拟的 ping 微秒数
+void BM_AcquireReleaseUnderKeepalive(benchmark::State& state) {
+    static SharedPool pool;
+    if (state.thread_index() == 0) {
+        pool.fake.ping_latency_us = static_cast<int>(state.range(0));
+    }
+    PoolOptions options = benchmarkPoolOptions();
+    options.validate_idle_sec = 0;
+    options.keepalive_interval_sec = 1;
+    pool.acquire(options);
+    for (auto _ : state) {
+        auto conn = pool.dao->getConnection();
+        benchmark::DoNotOptimize(conn.get());
+        pool.dao->releaseConnection(std::move(conn));
+    }
+    pool.release();
+}
+BENCHMARK(BM_AcquireReleaseUnderKeepalive)->Arg(0)->Arg(20)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#include "checkFixture.h"
+#include "requestScope.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 每个请求与 MySQL 之间的往返次数：requestScope 上的计数应与替身驱动实际收到的调用一致，
+// 且单行写操作只有一次往返、显式事务只多出 START TRANSACTION 与 COMMIT/ROLLBACK，
+// 全程不出现 setAutoCommit。预处理语句先预热进缓存，不计入断言
+
+namespace {
+
+// 在独立的请求作用域内执行 body，核对作用域计数、驱动计数与期望值
+void expectRoundTrips(FakeOptions& fake, const char* name, uint64_t expected,
+                      const std::function<bool()>& body, bool expect_ok = true,
+                      std::function<bool()> cancelled = nullptr) {
+    uint64_t before = fake.round_trips.load();
+    requestScope scope(requestScope::Clock::time_point::max(), std::move(cancelled));
+    bool ok = body();
+    uint64_t driver = fake.round_trips.load() - before;
+    uint64_t counted = scope.roundTrips();
+    bool pass = ok == expect_ok && counted == expected && driver == expected;
+    std::printf("%-24s %s  请求计数 %llu, 驱动计数 %llu, 期望 %llu\n", name, pass ? "通过" : "失败",
+                static_cast<unsigned long long>(counted), static_cast<unsigned long long>(driver),
+                static_cast<unsigned long long>(expected));
+    if (!pass) {
+        ++checkFailures();
+    }
+}
+
+}  // namespace
+
+int main() {
+    fakeDatabase db;
+    FakeOptions& fake = db.fake;
+    mysqlDao* primary = db.primary;
+    mysqlMgr& mgr = *db.mgr;
+
+    std::vector<BatchOp> batch = {
+        {BatchOp::Type::Insert, "alice", 30},
+        {BatchOp::Type::Update, "alice", 31},
+        {BatchOp::Type::Delete, "alice", 31},
+    };
+    std::vector<BatchOpResult> results;
+    std::vector<int> ages;
+
+    // 预热：各语句在连接上各 prepare 一次
+    mgr.insert("alice", 30);
+    mgr.update("alice", 30);
+    mgr.deleteData("alice", 30);
+    mgr.findByName("alice", ages);
+    mgr.executeBatch(batch, true, results);
+
+    expectRoundTrips(fake, "insert", 1, [&]() { return mgr.insert("alice", 30); });
+    expectRoundTrips(fake, "update", 1, [&]() { return mgr.update("alice", 31); });
+    expectRoundTrips(fake, "delete", 1, [&]() { return mgr.deleteData("alice", 31); });
+    expectRoundTrips(fake, "findByName", 1, [&]() { return mgr.findByName("alice", ages); });
+
+    // START TRANSACTION + 3 条语句 + COMMIT
+    expectRoundTrips(fake, "atomic batch", 5, [&]() { return mgr.executeBatch(batch, true, results); });
+
+    // START TRANSACTION + 1 条语句 + ROLLBACK，回滚后不再恢复 autocommit
+    expectRoundTrips(fake, "rolled back transaction", 3, [&]() {
+        return primary->executeInTransaction([](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare(userSql::INSERT.view());
+            userTable::bindRow(pstmt, {"bob", 20});
+            executeUpdate(pstmt);
+            return false;
+        });
+    }, false);
+
+    // 已取消的请求在执行前放弃，不产生往返
+    expectRoundTrips(fake, "cancelled insert", 0, [&]() { return mgr.insert("alice", 30); },
+                     false, []() { return true; });
+
+    expect(fake.autocommit_changes.load() == 0, "不出现 setAutoCommit");
+    return checkResult();
+}
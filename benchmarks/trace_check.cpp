@@ -0,0 +1,203 @@
+#include "checkFixture.h"
+#include "dbService.h"
+#include "asyncLogger.h"
+#include "slowLog.h"
+#include <grpcpp/grpcpp.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 请求追踪与慢请求日志：直接调用 DBServiceImpl 的处理函数（写入、批量写入、组提交模式下的写入），
+// 批量导入经本进程内的 gRPC 服务调用，从慢请求日志检查各阶段耗时、往返次数与 SQL 已记入追踪上下文、
+// 只有超过阈值或被抽中的请求写入日志，以及 Chrome trace 文件的格式。
+// 替身驱动的 COMMIT 延迟使批量写入、组提交写入与导入成为慢请求
+
+namespace {
+
+std::string readFile(const char* path) {
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+bool contains(const std::string& text, const char* part) {
+    return text.find(part) != std::string::npos;
+}
+
+// 等到慢请求日志写满 count 行，返回各行
+std::vector<std::string> waitLines(const char* path, std::size_t count) {
+    std::string content;
+    waitFor([&]() {
+        content = readFile(path);
+        return static_cast<std::size_t>(std::count(content.begin(), content.end(), '\n')) >= count;
+    });
+    std::vector<std::string> lines;
+    std::istringstream in(content);
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// phases_us 中某一阶段的耗时（微秒），不存在时返回 -1
+double phaseUs(const std::string& line, const char* phase) {
+    std::string key = std::string("\"") + phase + "\":";
+    std::size_t pos = line.find(key, line.find("\"phases_us\":"));
+    return pos == std::string::npos ? -1 : std::strtod(line.c_str() + pos + key.size(), nullptr);
+}
+
+DBRequest insertRequest(const std::string& name, int age) {
+    DBRequest request;
+    request.set_operation(DBRequest::INSERT);
+    request.mutable_user_info()->set_name(name);
+    request.mutable_user_info()->set_age(age);
+    return request;
+}
+
+}  // namespace
+
+int main() {
+    const char* slow_file = "trace_check_slow.log";
+    const char* chrome_file = "trace_check.trace.json";
+    std::remove(slow_file);
+    std::remove(chrome_file);
+
+    LogOptions log;
+    log.file = "trace_check.log";
+    asyncLogger::getInstance().configure(log);
+
+    // 先抽中全部请求，记录一次快速写入的完整阶段分解
+    TraceOptions options;
+    options.slow_ms = 20;
+    options.sample_rate = 1.0;
+    options.file = slow_file;
+    options.chrome_trace_file = chrome_file;
+    options.flush_interval_ms = 10;
+    slowLog& slow_log = slowLog::getInstance();
+    slow_log.configure(options);
+
+    // 关闭缓存与并发限制，往返次数只来自写入本身
+    ServerConfig config;
+    config.cache_enabled = false;
+    config.limiter_enabled = false;
+    fakeDatabase db;
+    db.fake.commit_latency_us = 30000;
+    DBServiceImpl service(config, db.release());
+    grpc::ServerContext context;
+
+    // 单行写入：一次借连接、一次 prepare（首次）与一次执行，低于阈值，按抽样写入
+    DBRequest insert = insertRequest("alice", 30);
+    DBResponse response;
+    expect(service.ExecuteOperation(&context, &insert, &response).ok(), "单行写入成功");
+    std::vector<std::string> lines = waitLines(slow_file, 1);
+    std::string sampled = lines.empty() ? std::string() : lines[0];
+    expect(contains(sampled, "\"op\":\"insert\"") && contains(sampled, "\"reason\":\"sampled\""),
+           "抽中的请求写入慢请求日志");
+    expect(phaseUs(sampled, "queue") > 0 && phaseUs(sampled, "acquire") > 0 && phaseUs(sampled, "prepare") > 0 &&
+           phaseUs(sampled, "execute") > 0 && phaseUs(sampled, "response") > 0,
+           "单行写入记录排队、借连接、prepare、执行、应答");
+    expect(phaseUs(sampled, "commit") == 0, "自动提交的写入没有 COMMIT 阶段");
+    expect(contains(sampled, "\"statements\":1") && contains(sampled, std::string(userSql::INSERT.view()).c_str()), "记录执行的 SQL");
+    expect(contains(sampled, "\"round_trips\":2"), "记录往返次数");
+
+    // 停止抽样：未超过阈值的请求不写入
+    options.sample_rate = 0.0;
+    slow_log.configure(options);
+    DBRequest fast = insertRequest("carol", 25);
+    service.ExecuteOperation(&context, &fast, &response);
+    expect(slow_log.recorded() == 1, "未超过阈值的请求不写入慢请求日志");
+
+    // 批量写入：四条语句在一个事务内执行，COMMIT 耗时 30ms 超过阈值
+    BatchRequest batch;
+    auto add = [&batch](DBRequest::OperationType operation, const char* name, int age) {
+        DBRequest* op = batch.add_operations();
+        op->set_operation(operation);
+        op->mutable_user_info()->set_name(name);
+        op->mutable_user_info()->set_age(age);
+    };
+    add(DBRequest::INSERT, "bob", 20);
+    add(DBRequest::UPDATE, "bob", 21);
+    add(DBRequest::UPDATE, "bob", 22);
+    add(DBRequest::DELETE, "bob", 22);
+    BatchResponse batch_response;
+    expect(service.ExecuteBatch(&context, &batch, &batch_response).ok(), "批量写入成功");
+    lines = waitLines(slow_file, 2);
+    std::string slow = lines.size() < 2 ? std::string() : lines[1];
+    std::size_t sql = slow.find("\"sql\":");
+    expect(contains(slow, "\"op\":\"batch\"") && contains(slow, "\"reason\":\"slow\"") &&
+           phaseUs(slow, "commit") >= 30000, "超过阈值的请求写入, COMMIT 阶段包含提交耗时");
+    expect(sql != std::string::npos && contains(slow, "\"statements\":4") &&
+           slow.find("UPDATE", sql) == slow.rfind("UPDATE") && slow.find("; UPDATE", sql) != std::string::npos &&
+           slow.find("; DELETE", sql) != std::string::npos, "相同语句只记一次, 不同语句依次记录");
+
+    // 组提交：写入交给提交线程，交出前计为排队，等待批次提交计为 COMMIT，之后计为应答
+    {
+        ServerConfig group_config = config;
+        group_config.group_commit_enabled = true;
+        fakeDatabase group_db;
+        group_db.fake.commit_latency_us = 30000;
+        DBServiceImpl group_service(group_config, group_db.release());
+        DBRequest deferred = insertRequest("dave", 40);
+        expect(group_service.ExecuteOperation(&context, &deferred, &response).ok(), "组提交写入成功");
+        lines = waitLines(slow_file, 3);
+        std::string line = lines.size() < 3 ? std::string() : lines[2];
+        expect(contains(line, "\"op\":\"insert\"") && phaseUs(line, "queue") > 0 &&
+               phaseUs(line, "commit") >= 30000 && phaseUs(line, "response") > 0,
+               "组提交写入记录排队、等待提交、应答");
+    }
+
+    // 批量导入：经 gRPC 流式调用，追踪覆盖整个导入的执行与应答
+    {
+        grpc::ServerBuilder builder;
+        builder.RegisterService(&service);
+        std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+        std::unique_ptr<DBService::Stub> stub = DBService::NewStub(server->InProcessChannel(grpc::ChannelArguments()));
+        grpc::ClientContext client_context;
+        ImportResponse import_response;
+        std::unique_ptr<grpc::ClientWriter<ImportRequest>> writer = stub->Import(&client_context, &import_response);
+        ImportRequest rows;
+        for (int i = 0; i < 10; ++i) {
+            UserInfo* row = rows.add_rows();
+            row->set_name("import_" + std::to_string(i));
+            row->set_age(i);
+        }
+        writer->Write(rows);
+        writer->WritesDone();
+        expect(writer->Finish().ok() && import_response.inserted() == 10, "批量导入成功");
+        lines = waitLines(slow_file, 4);
+        std::string line = lines.size() < 4 ? std::string() : lines[3];
+        expect(contains(line, "\"op\":\"import\"") && contains(line, "\"reason\":\"slow\"") &&
+               phaseUs(line, "execute") >= 30000, "批量导入记录整体执行耗时");
+        server->Shutdown();
+    }
+
+    // 关闭追踪：慢请求不再写入
+    options.enabled = false;
+    slow_log.configure(options);
+    uint64_t recorded = slow_log.recorded();
+    service.ExecuteBatch(&context, &batch, &batch_response);
+    expect(slow_log.recorded() == recorded, "关闭追踪时不写入慢请求日志");
+
+    // 超长 SQL 截断到 MAX_SQL
+    requestTrace truncated(requestTrace::Clock::now());
+    std::string long_sql(200, 'x');
+    truncated.noteSql(long_sql);
+    truncated.noteSql(long_sql + "y");
+    expect(truncated.sql().size() <= requestTrace::MAX_SQL && truncated.sqlTruncated(), "超长 SQL 截断");
+
+    std::string chrome;
+    waitFor([&]() {
+        chrome = readFile(chrome_file);
+        return contains(chrome, "\"name\":\"import\",\"cat\":\"rpc\"");
+    });
+    expect(chrome.compare(0, 2, "[\n") == 0 && contains(chrome, "\"name\":\"batch\",\"cat\":\"rpc\",\"ph\":\"X\"") &&
+           contains(chrome, "\"name\":\"commit\",\"cat\":\"phase\""), "Chrome trace 文件包含请求与各阶段事件");
+
+    return checkResult();
+}
@@ -0,0 +1,84 @@
+#include "checkFixture.h"
+#include "writeBehind.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+// 延迟写回：数据库可用时已确认的写操作写回 MySQL 并推进检查点；
+// 数据库不可达（连接类错误、熔断器断开）时整批保留、检查点不前进，恢复后照常写回，不丢失已确认的写入
+
+namespace {
+
+// 检查点文件的前 8 字节为已写回的 LSN
+uint64_t readCheckpoint(const std::string& dir) {
+    std::ifstream in(dir + "/checkpoint", std::ios::binary);
+    uint64_t lsn = 0;
+    in.read(reinterpret_cast<char*>(&lsn), sizeof(lsn));
+    return in ? lsn : 0;
+}
+
+}  // namespace
+
+int main() {
+    const std::string dir = "write_behind_check_wal";
+    std::filesystem::remove_all(dir);
+
+    BreakerOptions breaker;
+    breaker.consecutive_failures = 2;
+    breaker.open_ms = 20;
+    breaker.max_open_ms = 100;
+    breaker.half_open_requests = 1;
+    fakeDatabase db(fakeDatabase::singleConnection(), breaker);
+
+    WriteBehindOptions options;
+    options.dir = dir;
+    options.segment_mb = 1;
+    options.max_log_mb = 4;
+    std::atomic<uint64_t> applied_ops{0};
+    writeBehindLog log(*db.mgr, options, [&applied_ops](const std::vector<BatchOp>& ops) {
+        applied_ops.fetch_add(ops.size());
+    });
+
+    std::atomic<int> durable{0};
+    auto submit = [&](int count) {
+        bool ok = true;
+        for (int i = 0; i < count; ++i) {
+            ok = log.submit(BatchOp{BatchOp::Type::Insert, "user_" + std::to_string(i), i},
+                            [&durable](bool synced) {
+                if (synced) {
+                    durable.fetch_add(1);
+                }
+            }) && ok;
+        }
+        return ok;
+    };
+
+    // 数据库可用：确认后写回并推进检查点
+    expect(submit(3) && waitFor([&]() { return durable.load() == 3; }), "写入落盘后确认");
+    expect(waitFor([&]() { return log.stats().backlog == 0; }), "已确认的写入写回 MySQL");
+    uint64_t checkpoint = readCheckpoint(dir);
+    expect(checkpoint == 3 && applied_ops.load() == 3, "写回后推进检查点");
+
+    // 数据库不可达：写入照常确认，写回失败时保留整批、退避重试，检查点不前进
+    db.fake.reachable = false;
+    expect(submit(5) && waitFor([&]() { return durable.load() == 8; }), "数据库不可达时写入仍落盘确认");
+    expect(waitFor([&]() { return log.stats().apply_retries >= 3; }), "写回失败后退避重试");
+    writeBehindLog::Stats stats = log.stats();
+    expect(db.mgr->breaker().isOpen(), "连续写回失败使熔断器断开");
+    expect(stats.applied_lsn == 3 && stats.backlog == 5 && stats.apply_failures == 0,
+           "未写回的操作全部保留, 不计为丢弃");
+    expect(readCheckpoint(dir) == checkpoint && applied_ops.load() == 3, "数据库不可达期间检查点不前进");
+
+    // 数据库恢复：熔断器探测成功后保留的一批写回，检查点推进到最后一条
+    db.fake.reachable = true;
+    expect(waitFor([&]() { return log.stats().backlog == 0; }, std::chrono::seconds(10)),
+           "恢复后保留的写入全部写回");
+    expect(readCheckpoint(dir) == 8 && applied_ops.load() == 8, "恢复后检查点推进到最后一条");
+    expect(log.stats().apply_failures == 0, "恢复后写回没有丢弃任何操作");
+    expect(db.fake.updated_rows.load() == 8, "8 条已确认的写入全部写入数据库");
+
+    std::filesystem::remove_all(dir);
+    return checkResult();
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include "mysqlMgr.h"
+#include "dbExecutor.h"
+#include "requestScope.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 批量导入参数，对应 config.ini 的 [import] 部分
+struct ImportOptions {
+    int chunk_rows = 5000;          // chunk_rows: 每个分块的行数，一个分块在一个事务中以多行 INSERT 写入
+    int loaders = 4;                // loaders: 并行写入的线程数，即导入最多同时占用的连接数，所有 Import 共享
+    int max_inflight_chunks = 8;    // max_inflight_chunks: 单个 Import 已读取未写完的分块上限，达到后暂停读取
+    int max_errors = 100;           // max_errors: 响应中最多返回多少条失败记录的详情
+};
+
+// 批量导入：把客户端流入的记录攒成大分块，交给固定数量的写入线程在各自的连接上并行写入。
+// 单个导入在途的分块达到上限时 add() 阻塞，调用方随之停止读取客户端的流，
+// 由 HTTP/2 流量控制让客户端等待，导入速度跟随数据库的写入速度
+class bulkImporter {
+public:
+    using LoadedCallback = std::function<void(const std::vector<BatchOp>&)>;
+
+    struct RowError {
+        uint64_t index;  // 记录在流中的序号，从 0 开始
+        std::string name;
+        int age;
+        std::string message;
+    };
+
+    struct Result {
+        uint64_t received = 0;
+        uint64_t inserted = 0;
+        uint64_t failed = 0;
+        std::vector<RowError> errors;  // 最多 max_errors 条
+    };
+
+    // 一次 Import 调用；析构前等待所有分块写完
+    class session {
+    public:
+        session(bulkImporter& importer, requestScope::Clock::time_point deadline,
+                std::function<bool()> cancelled)
+            : importer_(importer), deadline_(deadline), cancelled_(std::move(cancelled)) {
+            chunk_.reserve(importer_.chunk_rows_);
+        }
+
+        ~session() {
+            wait();
+        }
+
+        session(const session&) = delete;
+        session& operator=(const session&) = delete;
+
+        void add(const std::string& name, int age) {
+            chunk_.push_back(BatchOp{BatchOp::Type::Insert, name, age});
+            if (chunk_.size() >= importer_.chunk_rows_) {
+                submit();
+            }
+        }
+
+        // 写入剩余的记录并等待全部完成
+        Result finish() {
+            if (!chunk_.empty()) {
+                submit();
+            }
+            wait();
+            std::lock_guard<std::mutex> lock(mutex_);
+            return result_;
+        }
+
+    private:
+        void submit() {
+            auto chunk = std::make_shared<std::vector<BatchOp>>(std::move(chunk_));
+            uint64_t first_index = next_index_;
+            next_index_ += chunk->size();
+            chunk_.clear();
+            chunk_.reserve(importer_.chunk_rows_);
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                result_.received += chunk->size();
+                cond_.wait(lock, [this]() { return inflight_ < importer_.max_inflight_chunks_; });
+                ++inflight_;
+            }
+            auto task = [this, chunk, first_index]() { load(*chunk, first_index); };
+            if (!importer_.loaders_.submit(task)) {
+                task();  // 写入线程的队列已满：在当前线程写入，同样起到限速作用
+            }
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return inflight_ == 0; });
+        }
+
+        void load(const std::vector<BatchOp>& chunk, uint64_t first_index) {
+            std::vector<BatchOpResult> results;
+            {
+                // 客户端取消或超时后剩余的分块不再写入
+                requestScope scope(deadline_, cancelled_);
+                if (scope.aborted()) {
+                    results.assign(chunk.size(), BatchOpResult{false, "导入已取消或已超时"});
+                } else {
+                    try {
+                        // 尽力模式：多行 INSERT 失败时逐行重试，定位失败的记录
+                        importer_.mgr_.executeBatch(chunk, false, results);
+                    } catch (const std::exception& e) {
+                        results.assign(chunk.size(), BatchOpResult{false, e.what()});
+                    }
+                }
+            }
+            if (importer_.on_loaded_) {
+                try {
+                    importer_.on_loaded_(chunk);
+                } catch (const std::exception& e) {
+                    std::cerr << "导入回调异常: " << e.what() << std::endl;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t i = 0; i < chunk.size(); ++i) {
+                if (results[i].success) {
+                    ++result_.inserted;
+                    continue;
+                }
+                ++result_.failed;
+                if (result_.errors.size() < importer_.max_errors_) {
+                    result_.errors.push_back(RowError{first_index + i, chunk[i].name, chunk[i].age,
+                                                      results[i].message});
+                }
+            }
+            --inflight_;
+            cond_.notify_all();
+        }
+
+        bulkImporter& importer_;
+        const requestScope::Clock::time_point deadline_;
+        const std::function<bool()> cancelled_;
+        std::vector<BatchOp> chunk_;
+        uint64_t next_index_ = 0;
+
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        int inflight_ = 0;
+        Result result_;
+    };
+
+    // on_loaded 在每个分块写入后于写入线程中调用，用于使缓存失效
+    bulkImporter(mysqlMgr& mgr, const ImportOptions& options, LoadedCallback on_loaded)
+        : mgr_(mgr),
+          on_loaded_(std::move(on_loaded)),
+          chunk_rows_(static_cast<std::size_t>(std::max(1, options.chunk_rows))),
+          max_inflight_chunks_(std::max(1, options.max_inflight_chunks)),
+          max_errors_(static_cast<std::size_t>(std::max(0, options.max_errors))),
+          loaders_(std::max(1, options.loaders),
+                   static_cast<std::size_t>(std::max(1, options.max_inflight_chunks))) {}
+
+    bulkImporter(const bulkImporter&) = delete;
+    bulkImporter& operator=(const bulkImporter&) = delete;
+
+private:
+    mysqlMgr& mgr_;
+    LoadedCallback on_loaded_;
+    const std::size_t chunk_rows_;
+    const int max_inflight_chunks_;
+    const std::size_t max_errors_;
+    dbExecutor loaders_;  // 最后构造、最先析构：析构时等待已提交的分块写完
+};
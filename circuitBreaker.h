@@ -0,0 +1,246 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+// 熔断参数，对应 config.ini 的 [breaker] 部分；主库与每个只读副本的连接池各有一个熔断器
+struct BreakerOptions {
+    bool enabled = true;           // enabled: 0 关闭
+    int window_ms = 10000;         // window_ms: 统计错误率的固定窗口
+    int min_requests = 20;         // min_requests: 窗口内请求数不少于该值才按错误率断开
+    double failure_ratio = 0.5;    // failure_ratio: 窗口内连接类错误占比达到该值即断开
+    int consecutive_failures = 5;  // consecutive_failures: 连续出现该数量的连接类错误即断开
+    int open_ms = 500;             // open_ms: 断开后首次后台探测的间隔
+    int max_open_ms = 30000;       // max_open_ms: 探测间隔指数增长的上限
+    int half_open_requests = 3;    // half_open_requests: 半开时放行的试探请求数，全部成功才闭合
+};
+
+// 数据库连接池前的熔断器。闭合时统计连接类错误，连续失败或窗口内错误率过高时断开；
+// 断开期间请求直接拒绝，不再等待连接池或建连超时，由连接池维护线程按带抖动的指数退避
+// 在后台建连探测。探测成功转为半开，放行少量请求，全部成功后闭合，任一失败重新断开并加倍退避
+class circuitBreaker {
+public:
+    enum class State { Closed, Open, HalfOpen };
+    using Clock = std::chrono::steady_clock;
+
+    explicit circuitBreaker(const BreakerOptions& options)
+        : enabled_(options.enabled),
+          window_(std::chrono::milliseconds(std::max(1, options.window_ms))),
+          min_requests_(std::max(1, options.min_requests)),
+          failure_ratio_(std::min(1.0, std::max(0.0, options.failure_ratio))),
+          consecutive_limit_(std::max(1, options.consecutive_failures)),
+          open_ms_(std::max(1, options.open_ms)),
+          max_open_ms_(std::max(open_ms_, options.max_open_ms)),
+          half_open_requests_(std::max(1, options.half_open_requests)),
+          backoff_ms_(open_ms_) {}
+
+    // 请求借连接前调用：闭合时放行；断开时拒绝；半开时至多放行 half_open_requests 个试探请求
+    bool allow() {
+        if (!enabled_ || state_.load(std::memory_order_acquire) == State::Closed) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Closed) {
+            return true;
+        }
+        if (state_ == State::HalfOpen) {
+            // 放行的试探请求迟迟没有结果（如在执行前被取消）时，再放行一批
+            auto now = Clock::now();
+            if (half_open_admitted_ >= half_open_requests_ &&
+                now - half_open_since_ >= std::chrono::milliseconds(open_ms_)) {
+                half_open_admitted_ = half_open_successes_;
+                half_open_since_ = now;
+            }
+            if (half_open_admitted_ < half_open_requests_) {
+                ++half_open_admitted_;
+                return true;
+            }
+        }
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 语句已在数据库上执行完成（包括约束冲突等业务错误），说明数据库可达；返回 true 表示本次成功使熔断器闭合
+    bool onSuccess() {
+        if (!enabled_) {
+            return false;
+        }
+        if (state_.load(std::memory_order_acquire) == State::Closed) {
+            requests_.fetch_add(1, std::memory_order_relaxed);
+            if (consecutive_.load(std::memory_order_relaxed) != 0) {
+                consecutive_.store(0, std::memory_order_relaxed);
+            }
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::HalfOpen || ++half_open_successes_ < half_open_requests_) {
+            return false;
+        }
+        state_.store(State::Closed, std::memory_order_release);
+        backoff_ms_ = open_ms_;
+        window_start_ = Clock::now();
+        requests_.store(0, std::memory_order_relaxed);
+        failures_ = 0;
+        consecutive_.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 连接类错误（建连失败、连接中断、服务端关闭等）；返回 true 表示本次失败使熔断器断开
+    bool onFailure() {
+        if (!enabled_) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        if (state_ == State::Open) {
+            return false;
+        }
+        if (state_ == State::HalfOpen) {
+            open(now, std::min(max_open_ms_, backoff_ms_ * 2));
+            return true;
+        }
+
+        // 固定窗口：过期后从本次失败重新计数
+        if (now - window_start_ >= window_) {
+            window_start_ = now;
+            requests_.store(0, std::memory_order_relaxed);
+            failures_ = 0;
+        }
+        uint64_t requests = requests_.fetch_add(1, std::memory_order_relaxed) + 1;
+        ++failures_;
+        int consecutive = consecutive_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (consecutive >= consecutive_limit_ ||
+            (requests >= static_cast<uint64_t>(min_requests_) &&
+             static_cast<double>(failures_) >= failure_ratio_ * static_cast<double>(requests))) {
+            open(now, open_ms_);
+            return true;
+        }
+        return false;
+    }
+
+    // 下一次后台探测的时间，到期后由调用方建连并 ping，再报告 onProbeSuccess/onProbeFailure
+    Clock::time_point nextProbe() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return next_probe_;
+    }
+
+    void onProbeSuccess() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Open) {
+            state_.store(State::HalfOpen, std::memory_order_release);
+            half_open_since_ = Clock::now();
+            half_open_admitted_ = 0;
+            half_open_successes_ = 0;
+        }
+    }
+
+    // 返回下一次探测前的等待时长
+    std::chrono::milliseconds onProbeFailure() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Open) {
+            return std::chrono::milliseconds(0);
+        }
+        backoff_ms_ = std::min(max_open_ms_, backoff_ms_ * 2);
+        auto delay = jittered(std::chrono::milliseconds(backoff_ms_));
+        next_probe_ = Clock::now() + delay;
+        return delay;
+    }
+
+    State state() const {
+        return state_.load(std::memory_order_acquire);
+    }
+
+    // 断开状态下请求会被直接拒绝；半开时仍可能放行
+    bool isOpen() const {
+        return enabled_ && state() == State::Open;
+    }
+
+    // 建议客户端等待多久再重试：距下一次后台探测的时长
+    std::chrono::milliseconds retryAfter() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Closed) {
+            return std::chrono::milliseconds(0);
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(next_probe_ - Clock::now());
+        return std::max(left, std::chrono::milliseconds(0));
+    }
+
+    uint64_t rejected() const {
+        return rejected_.load(std::memory_order_relaxed);
+    }
+
+    // 指标导出用的一次性快照，主库与每个副本各导出一份
+    struct Snapshot {
+        State state;
+        uint64_t rejected;
+        uint64_t opened;
+        std::chrono::milliseconds retry_after;
+    };
+
+    Snapshot snapshot() const {
+        return Snapshot{state(), rejected(), opened(), retryAfter()};
+    }
+
+    uint64_t opened() const {
+        return opened_.load(std::memory_order_relaxed);
+    }
+
+    static const char* stateName(State state) {
+        switch (state) {
+            case State::Open:
+                return "open";
+            case State::HalfOpen:
+                return "half_open";
+            default:
+                return "closed";
+        }
+    }
+
+    // 等抖动退避：在 [delay/2, delay] 内均匀取值，多个实例不会在同一时刻一起探测
+    static std::chrono::milliseconds jittered(std::chrono::milliseconds delay) {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        delay = std::max(delay, std::chrono::milliseconds(1));
+        long long half = std::max<long long>(1, delay.count() / 2);
+        std::uniform_int_distribution<long long> dist(0, delay.count() - half);
+        return std::chrono::milliseconds(half + dist(rng));
+    }
+
+private:
+    // 调用方持有 mutex_
+    void open(Clock::time_point now, int backoff_ms) {
+        state_.store(State::Open, std::memory_order_release);
+        opened_.fetch_add(1, std::memory_order_relaxed);
+        backoff_ms_ = backoff_ms;
+        next_probe_ = now + jittered(std::chrono::milliseconds(backoff_ms_));
+        half_open_admitted_ = 0;
+        half_open_successes_ = 0;
+    }
+
+    const bool enabled_;
+    const Clock::duration window_;
+    const int min_requests_;
+    const double failure_ratio_;
+    const int consecutive_limit_;
+    const int open_ms_;
+    const int max_open_ms_;
+    const int half_open_requests_;
+
+    std::atomic<State> state_{State::Closed};
+    std::atomic<uint64_t> requests_{0};  // 当前窗口内的请求数，成功路径无锁累加
+    std::atomic<int> consecutive_{0};
+
+    mutable std::mutex mutex_;
+    Clock::time_point window_start_ = Clock::now();
+    uint64_t failures_ = 0;
+    int backoff_ms_;
+    Clock::time_point next_probe_;
+    Clock::time_point half_open_since_;
+    int half_open_admitted_ = 0;
+    int half_open_successes_ = 0;
+
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> opened_{0};
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+// 并发限制参数，对应 config.ini 的 [limiter] 部分
+struct LimiterOptions {
+    int initial_limit = 32;      // initial_limit: 初始并发上限，默认取连接池上限的 2 倍
+    int min_limit = 4;           // min_limit: 收缩的下限
+    int max_limit = 1000;        // max_limit: 增长的上限
+    double tolerance = 2.0;      // tolerance: 短期延迟超过长期基线的该倍数才开始收缩
+    double backoff_ratio = 0.9;  // backoff_ratio: 请求超时或被下游拒绝时的乘性收缩比例
+    int long_window = 600;       // long_window: 长期延迟基线的平滑样本数
+};
+
+// 自适应并发限制：数据库层前的准入控制，进行中的请求数达到上限即拒绝，
+// 让排队在延迟失控之前就停止增长。上限按延迟梯度调整：
+// 短期延迟接近长期基线时加性增长（每个样本约 sqrt(limit)），
+// 短期延迟超过基线 tolerance 倍时按比例收缩，请求超时或被拒绝时乘性收缩
+class concurrencyLimiter {
+public:
+    explicit concurrencyLimiter(const LimiterOptions& options) {
+        reconfigure(options);
+        limit_ = std::min(max_limit_, std::max(min_limit_, options.initial_limit));
+        publish();
+    }
+
+    // 热加载：收缩与增长的参数立即生效，当前上限夹到新的 [min_limit, max_limit] 内；
+    // initial_limit 只在启动时使用
+    void reconfigure(const LimiterOptions& options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        min_limit_ = std::max(1, options.min_limit);
+        max_limit_ = std::max(min_limit_, options.max_limit);
+        tolerance_ = std::max(1.0, options.tolerance);
+        backoff_ratio_ = std::min(1.0, std::max(0.1, options.backoff_ratio));
+        long_window_ = std::max(1, options.long_window);
+        limit_ = std::min<double>(max_limit_, std::max<double>(min_limit_, limit_));
+        publish();
+    }
+
+    // 取得一个许可；返回 true 时调用方必须在请求结束后调用 onSuccess/onDropped/onIgnore 之一
+    bool tryAcquire() {
+        int inflight = inflight_.load(std::memory_order_relaxed);
+        do {
+            if (inflight >= published_limit_.load(std::memory_order_relaxed)) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!inflight_.compare_exchange_weak(inflight, inflight + 1, std::memory_order_relaxed));
+        return true;
+    }
+
+    // 请求已完成：归还许可并提交一个延迟样本
+    void onSuccess(std::chrono::steady_clock::duration latency) {
+        int inflight = inflight_.fetch_sub(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        double rtt = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(latency).count()) + 1.0;
+        short_rtt_ = short_rtt_ == 0 ? rtt : short_rtt_ + (rtt - short_rtt_) / SHORT_WINDOW;
+        long_rtt_ = long_rtt_ == 0 ? rtt : long_rtt_ + (rtt - long_rtt_) / long_window_;
+        // 负载骤降后短期延迟远低于基线，让基线尽快回落，避免之后的过载迟迟不被发现
+        if (long_rtt_ > 2 * short_rtt_) {
+            long_rtt_ *= 0.95;
+        }
+
+        double gradient = std::max(0.5, std::min(1.0, tolerance_ * long_rtt_ / short_rtt_));
+        double next = limit_ * gradient + std::sqrt(limit_);
+        next = limit_ * (1 - SMOOTHING) + next * SMOOTHING;
+        // 进行中的请求不到上限的一半时说明并发不是瓶颈，不再放大上限
+        if (next > limit_ && inflight < limit_ / 2) {
+            return;
+        }
+        limit_ = std::min<double>(max_limit_, std::max<double>(min_limit_, next));
+        publish();
+    }
+
+    // 请求因过载失败（超时、下游排队已满）：延迟样本不可信，直接乘性收缩
+    void onDropped() {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = std::max<double>(min_limit_, limit_ * backoff_ratio_);
+        publish();
+    }
+
+    // 请求未正常完成且与负载无关（如客户端取消）：只归还许可
+    void onIgnore() {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    int limit() const {
+        return published_limit_.load(std::memory_order_relaxed);
+    }
+
+    int inflight() const {
+        return inflight_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t rejected() const {
+        return rejected_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr double SHORT_WINDOW = 10;
+    static constexpr double SMOOTHING = 0.2;
+
+    void publish() {
+        published_limit_.store(static_cast<int>(limit_), std::memory_order_relaxed);
+    }
+
+    std::mutex mutex_;  // 保护以下参数与上限的计算
+    int min_limit_ = 1;
+    int max_limit_ = 1;
+    double tolerance_ = 1.0;
+    double backoff_ratio_ = 1.0;
+    double long_window_ = 1;
+    double limit_ = 1;
+    double short_rtt_ = 0;  // 微秒
+    double long_rtt_ = 0;
+
+    std::atomic<int> published_limit_{1};
+    std::atomic<int> inflight_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
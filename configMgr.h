@@ -1,67 +1,192 @@
 #pragma once
+#include "serverConfig.h"
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
+#include <vector>
 
+// 配置管理：config.ini 解析为 ServerConfig 快照，通过原子指针交换发布。
+// 读取方持有 current() 返回的快照即可无锁读取；watch() 之后文件被修改时自动重新加载，
+// 解析失败保留原配置，成功后依次通知订阅方应用新配置
 class configMgr {
 public:
+    using Listener = std::function<void(const ServerConfig& previous, const ServerConfig& next)>;
+
     static configMgr& getInstance() {
         static configMgr instance;
         return instance;
     }
 
-    std::string getValue(const std::string& section, const std::string& key) const {
+    // 当前生效的配置；返回的快照在持有期间不会被释放
+    std::shared_ptr<const ServerConfig> current() const {
+        return std::atomic_load(&current_);
+    }
+
+    // 订阅的生命周期：析构时取消订阅，并等待正在进行的通知结束，
+    // 之后 listener 不会再被调用，它引用的对象可以安全销毁
+    class Subscription {
+    public:
+        Subscription(configMgr* owner, uint64_t id) : owner_(owner), id_(id) {}
+        Subscription(Subscription&& other) noexcept : owner_(other.owner_), id_(other.id_) {
+            other.owner_ = nullptr;
+        }
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+        Subscription& operator=(Subscription&&) = delete;
+
+        ~Subscription() {
+            if (owner_) {
+                owner_->unsubscribe(id_);
+            }
+        }
+
+    private:
+        configMgr* owner_;
+        uint64_t id_;
+    };
+
+    // 配置热加载后在监听线程中调用 listener，直到返回的 Subscription 被销毁
+    [[nodiscard]] Subscription subscribe(Listener listener) {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        uint64_t id = ++next_listener_;
+        listeners_.emplace_back(id, std::move(listener));
+        return Subscription(this, id);
+    }
+
+    // 重新读取配置文件；解析或校验失败时保留原配置并返回 false
+    bool reload() {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        std::shared_ptr<const ServerConfig> next;
         try {
-            return pt.get<std::string>(section + "." + key);
+            next = load(filename_);
         } catch (const std::exception& e) {
-            std::cerr << "配置读取错误: " << section << "." << key << " - " << e.what() << std::endl;
-            throw;
+            std::cerr << "配置重新加载失败, 保留原配置: " << e.what() << std::endl;
+            return false;
+        }
+        std::shared_ptr<const ServerConfig> previous = std::atomic_exchange(&current_, next);
+        std::cout << "配置已重新加载: " << filename_ << std::endl;
+        for (const auto& listener : listeners_) {
+            try {
+                listener.second(*previous, *next);
+            } catch (const std::exception& e) {
+                std::cerr << "应用新配置失败: " << e.what() << std::endl;
+            }
         }
+        return true;
     }
 
-    void loadConfig(const std::string& filename = "config.ini") {
+    // 启动后台线程，通过 inotify 监听配置文件的修改
+    void watch() {
+        if (watcher_.joinable()) {
+            return;
+        }
+        watcher_ = std::thread([this]() { watchLoop(); });
+    }
+
+    ~configMgr() {
+        stop_ = true;
+        if (watcher_.joinable()) {
+            watcher_.join();
+        }
+    }
+
+private:
+    // reload 在持有 reload_mutex_ 时通知订阅方，取得锁即说明没有进行中的通知
+    void unsubscribe(uint64_t id) {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+                                        [id](const auto& listener) { return listener.first == id; }),
+                         listeners_.end());
+    }
+
+    explicit configMgr(const std::string& filename = "config.ini") : filename_(filename) {
         try {
-            boost::property_tree::ini_parser::read_ini(filename, pt);
-            validateConfig();
+            current_ = load(filename_);
         } catch (const std::exception& e) {
             std::cerr << "配置文件加载失败: " << e.what() << std::endl;
             throw;
         }
     }
 
-private:
-    configMgr() {
-        loadConfig();
+    static std::shared_ptr<const ServerConfig> load(const std::string& filename) {
+        boost::property_tree::ptree pt;
+        boost::property_tree::ini_parser::read_ini(filename, pt);
+        return std::make_shared<const ServerConfig>(ServerConfig::parse(pt));
     }
 
-    void validateConfig() {
-        // 验证必需的配置项
-        validateSection("mysql", {"host", "port", "user", "password", "database"});
-        validateSection("grpc", {"host", "port"});
-        
-        // 验证端口号
-        try {
-            int mysql_port = pt.get<int>("mysql.port");
-            int grpc_port = pt.get<int>("grpc.port");
-            if (mysql_port <= 0 || mysql_port > 65535 ||
-                grpc_port <= 0 || grpc_port > 65535) {
-                throw std::runtime_error("端口号必须在 1-65535 范围内");
-            }
-        } catch (const boost::property_tree::ptree_bad_data& e) {
-            throw std::runtime_error("端口号必须是有效的数字");
+    // 监听配置文件所在目录而不是文件本身：编辑器与配置下发工具通常写临时文件再改名替换，
+    // 原文件的 watch 会随之失效。一次保存可能触发多个事件，合并后只加载一次
+    void watchLoop() {
+        std::string dir = ".";
+        std::string name = filename_;
+        std::size_t slash = filename_.rfind('/');
+        if (slash != std::string::npos) {
+            dir = slash == 0 ? "/" : filename_.substr(0, slash);
+            name = filename_.substr(slash + 1);
         }
-    }
 
-    void validateSection(const std::string& section, 
-                        const std::vector<std::string>& required_keys) {
-        for (const auto& key : required_keys) {
-            if (pt.get<std::string>(section + "." + key, "").empty()) {
-                throw std::runtime_error(section + " 部分缺少必需的配置项: " + key);
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "inotify 初始化失败, 配置热加载不可用" << std::endl;
+            return;
+        }
+        if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            std::cerr << "无法监听配置目录: " << dir << ", 配置热加载不可用" << std::endl;
+            close(fd);
+            return;
+        }
+        std::cout << "正在监听配置文件变更: " << filename_ << std::endl;
+
+        alignas(inotify_event) char buffer[4096];
+        bool pending = false;
+        while (!stop_) {
+            pollfd pfd{fd, POLLIN, 0};
+            // 有待加载的修改时等待 DEBOUNCE_MS 内不再有新事件再加载
+            int ready = poll(&pfd, 1, pending ? DEBOUNCE_MS : POLL_INTERVAL_MS);
+            if (ready < 0) {
+                continue;
+            }
+            if (ready == 0) {
+                if (pending) {
+                    pending = false;
+                    reload();
+                }
+                continue;
+            }
+
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + len; ) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    if (event->len > 0 && name == event->name) {
+                        pending = true;
+                    }
+                    p += sizeof(inotify_event) + event->len;
+                }
             }
         }
+        close(fd);
     }
 
-    boost::property_tree::ptree pt;
-};
+    static const int DEBOUNCE_MS = 200;
+    static const int POLL_INTERVAL_MS = 500;
 
+    const std::string filename_;
+    std::shared_ptr<const ServerConfig> current_;  // 只通过 std::atomic_load/atomic_exchange 访问
+    std::mutex reload_mutex_;                      // 串行化重新加载与通知
+    std::vector<std::pair<uint64_t, Listener>> listeners_;
+    uint64_t next_listener_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread watcher_;
+};
@@ -0,0 +1,491 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
+#include "mgrMysql.grpc.pb.h"
+#include "dbMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// 客户端参数
+struct ClientOptions {
+    std::string target = "localhost:50051";
+    int channels = 4;               // channels: 独立的 HTTP/2 连接数，调用按轮询分散到各连接
+    int cq_threads = 2;             // cq_threads: CompletionQueue 个数，每个队列一个轮询线程
+    int deadline_ms = 1000;         // deadline_ms: 每次调用默认的截止时间，<= 0 表示不设置
+    bool hedge_reads = true;        // hedge_reads: 幂等读请求（GetUser）超过 hedge_percentile 延迟仍未返回时，
+                                    // 在另一个连接上再发一次，先返回的结果生效
+    double hedge_percentile = 0.95;
+    int hedge_min_delay_us = 500;   // hedge_min_delay_us: 对冲延迟的下限，延迟很低时不值得多发一次
+    double hedge_budget = 0.05;     // hedge_budget: 对冲请求数占读请求数的上限，避免过载时放大负载
+    std::string session_id;         // session_id: 非空时作为 x-session-id 发送，读写分离下读到本会话的写入
+};
+
+// 一次调用的结果：status 不为 OK 时 response 为空
+template<typename Response>
+struct CallResult {
+    grpc::Status status;
+    Response response;
+
+    bool ok() const {
+        return status.ok();
+    }
+};
+
+// 可嵌入的客户端库：多个独立连接组成的连接池，基于 CompletionQueue 的异步调用，
+// 每次调用带截止时间；幂等读请求按近期 p95 延迟发出对冲请求以压低尾延迟。
+// 回调在完成队列线程上执行，不应阻塞；也可以使用返回 std::future 的重载。
+// 库本身不打印任何输出
+class DBClient {
+public:
+    template<typename Response>
+    using Callback = std::function<void(const grpc::Status&, Response&&)>;
+
+    // 作为 timeout 参数时表示使用 ClientOptions::deadline_ms
+    static constexpr std::chrono::milliseconds DEFAULT_DEADLINE{-1};
+
+    struct Stats {
+        uint64_t reads;           // 可对冲的读请求数
+        uint64_t hedged;          // 发出的对冲请求数
+        uint64_t hedge_wins;      // 对冲请求先于原请求返回的次数
+        uint64_t hedge_delay_us;  // 当前的对冲延迟，0 表示样本不足尚未启用
+    };
+
+    explicit DBClient(const ClientOptions& options = ClientOptions())
+        : options_(options),
+          hedge_min_delay_us_(static_cast<uint64_t>(std::max(0, options.hedge_min_delay_us))) {
+        int channels = std::max(1, options_.channels);
+        for (int i = 0; i < channels; ++i) {
+            // 独立的子通道池保证每个 channel 各自建立一条 TCP 连接
+            grpc::ChannelArguments args;
+            args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+            stubs_.push_back(db_operations::DBService::NewStub(grpc::CreateCustomChannel(
+                options_.target, grpc::InsecureChannelCredentials(), args)));
+        }
+        int cq_threads = std::max(1, options_.cq_threads);
+        for (int i = 0; i < cq_threads; ++i) {
+            queues_.push_back(std::make_unique<grpc::CompletionQueue>());
+        }
+        for (auto& queue : queues_) {
+            grpc::CompletionQueue* cq = queue.get();
+            pollers_.emplace_back([cq]() { poll(cq); });
+        }
+    }
+
+    // 取消所有进行中的调用（回调以 CANCELLED 结束）与尚未触发的对冲定时器，
+    // 关闭完成队列前不再有新的尝试投递到队列上；等待队列上的事件全部处理完后返回
+    ~DBClient() {
+        {
+            std::lock_guard<std::mutex> lock(calls_mutex_);
+            for (callBase* call : calls_) {
+                call->cancel();
+            }
+        }
+        for (auto& queue : queues_) {
+            queue->Shutdown();
+        }
+        for (auto& poller : pollers_) {
+            poller.join();
+        }
+    }
+
+    DBClient(const DBClient&) = delete;
+    DBClient& operator=(const DBClient&) = delete;
+
+    void ExecuteOperation(const db_operations::DBRequest& request, Callback<db_operations::DBResponse> done,
+                          std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        start(&Stub::PrepareAsyncExecuteOperation, request, std::move(done), timeout, false);
+    }
+
+    std::future<CallResult<db_operations::DBResponse>> ExecuteOperation(
+            db_operations::DBRequest::OperationType operation, const std::string& name, int age,
+            std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        db_operations::DBRequest request;
+        request.set_operation(operation);
+        request.mutable_user_info()->set_name(name);
+        request.mutable_user_info()->set_age(age);
+        return withFuture<db_operations::DBResponse>([&](Callback<db_operations::DBResponse> done) {
+            ExecuteOperation(request, std::move(done), timeout);
+        });
+    }
+
+    void ExecuteBatch(const db_operations::BatchRequest& request, Callback<db_operations::BatchResponse> done,
+                      std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        start(&Stub::PrepareAsyncExecuteBatch, request, std::move(done), timeout, false);
+    }
+
+    std::future<CallResult<db_operations::BatchResponse>> ExecuteBatch(
+            const db_operations::BatchRequest& request, std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        return withFuture<db_operations::BatchResponse>([&](Callback<db_operations::BatchResponse> done) {
+            ExecuteBatch(request, std::move(done), timeout);
+        });
+    }
+
+    void GetUser(const db_operations::GetUserRequest& request, Callback<db_operations::GetUserResponse> done,
+                 std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        start(&Stub::PrepareAsyncGetUser, request, std::move(done), timeout, options_.hedge_reads);
+    }
+
+    std::future<CallResult<db_operations::GetUserResponse>> GetUser(
+            const std::string& name, std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        db_operations::GetUserRequest request;
+        request.set_name(name);
+        return withFuture<db_operations::GetUserResponse>([&](Callback<db_operations::GetUserResponse> done) {
+            GetUser(request, std::move(done), timeout);
+        });
+    }
+
+    // 流式查询（同步）：每收到一条记录调用一次 on_row，on_row 返回 false 时提前结束并返回 OK
+    grpc::Status Query(const db_operations::QueryRequest& request,
+                       const std::function<bool(const db_operations::QueryResponse&)>& on_row,
+                       std::chrono::milliseconds timeout = DEFAULT_DEADLINE) {
+        grpc::ClientContext context;
+        prepareContext(context, deadlineOf(timeout));
+        auto reader = stubs_[nextIndex(channel_cursor_, stubs_.size())]->Query(&context, request);
+        db_operations::QueryResponse row;
+        bool stopped = false;
+        while (reader->Read(&row)) {
+            if (!on_row(row)) {
+                stopped = true;
+                context.TryCancel();
+                break;
+            }
+        }
+        grpc::Status status = reader->Finish();
+        return stopped ? grpc::Status::OK : status;
+    }
+
+    // 批量导入（同步）：反复调用 next_row 取下一条记录，返回 false 表示没有更多记录；
+    // 记录每 IMPORT_ROWS_PER_MESSAGE 条打包成一条消息发送，服务端写入跟不上时 Write 阻塞。
+    // 导入耗时与数据量相关，默认不设截止时间
+    grpc::Status Import(const std::function<bool(db_operations::UserInfo&)>& next_row,
+                        db_operations::ImportResponse* response,
+                        std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        grpc::ClientContext context;
+        prepareContext(context, deadlineOf(timeout));
+        auto writer = stubs_[nextIndex(channel_cursor_, stubs_.size())]->Import(&context, response);
+        db_operations::ImportRequest request;
+        db_operations::UserInfo row;
+        bool more = true;
+        while (more) {
+            more = next_row(row);
+            if (more) {
+                request.add_rows()->Swap(&row);
+                row.Clear();
+            }
+            if (request.rows_size() >= IMPORT_ROWS_PER_MESSAGE || (!more && request.rows_size() > 0)) {
+                if (!writer->Write(request)) {
+                    break;  // 服务端已结束调用，原因见 Finish 的状态
+                }
+                request.clear_rows();
+            }
+        }
+        writer->WritesDone();
+        return writer->Finish();
+    }
+
+    Stats stats() const {
+        return Stats{reads_.load(), hedged_.load(), hedge_wins_.load(), hedge_delay_us_.load()};
+    }
+
+private:
+    using Stub = db_operations::DBService::Stub;
+    using Clock = std::chrono::system_clock;
+
+    template<typename Request, typename Response>
+    using PrepareFn = std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> (Stub::*)(
+        grpc::ClientContext*, const Request&, grpc::CompletionQueue*);
+
+    // 完成队列上的事件，tag 即事件对象本身
+    struct completionEvent {
+        virtual void proceed(bool ok) = 0;
+        virtual ~completionEvent() = default;
+    };
+
+    // 进行中的调用，客户端析构时逐个取消
+    struct callBase {
+        virtual void cancel() = 0;
+        virtual ~callBase() = default;
+    };
+
+    // 一次一元调用：最多两次尝试（原请求与对冲请求）加一个对冲定时器，
+    // 全部事件都投递到同一个完成队列；最后一个事件处理完后自行删除
+    template<typename Request, typename Response>
+    class unaryCall final : public callBase {
+    public:
+        unaryCall(DBClient& client, PrepareFn<Request, Response> prepare, const Request& request,
+                  Callback<Response> done, Clock::time_point deadline, grpc::CompletionQueue* cq)
+            : client_(client), prepare_(prepare), request_(request), done_(std::move(done)),
+              deadline_(deadline), cq_(cq) {}
+
+        void start(std::size_t channel, bool hedge) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            channel_ = channel;
+            hedge_ = hedge;
+            launch(0);
+            uint64_t delay_us = hedge ? client_.hedge_delay_us_.load(std::memory_order_relaxed) : 0;
+            if (delay_us > 0) {
+                timer_.call = this;
+                timer_pending_ = true;
+                ++pending_;
+                timer_.alarm.Set(cq_, Clock::now() + std::chrono::microseconds(delay_us), &timer_);
+            }
+        }
+
+        // 客户端析构时调用：取消进行中的尝试与对冲定时器，之后不再发起对冲请求。
+        // 各事件仍会从完成队列取出，最后一个处理完后照常删除
+        void cancel() override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+            for (auto& current : attempts_) {
+                if (current) {
+                    current->context.TryCancel();
+                }
+            }
+            if (timer_pending_) {
+                timer_.alarm.Cancel();
+            }
+        }
+
+    private:
+        struct attempt final : completionEvent {
+            unaryCall* call = nullptr;
+            int index = 0;
+            grpc::ClientContext context;
+            Response response;
+            grpc::Status status;
+            std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+            std::chrono::steady_clock::time_point started;
+
+            void proceed(bool /*ok*/) override {
+                call->onAttempt(*this);
+            }
+        };
+
+        struct hedgeTimer final : completionEvent {
+            unaryCall* call = nullptr;
+            grpc::Alarm alarm;
+
+            void proceed(bool ok) override {
+                call->onTimer(ok);
+            }
+        };
+
+        // 在第 channel_ + index 个连接上发起第 index 次尝试，对冲请求总是走另一个连接
+        void launch(int index) {
+            auto& current = attempts_[index];
+            current = std::make_unique<attempt>();
+            current->call = this;
+            current->index = index;
+            current->started = std::chrono::steady_clock::now();
+            client_.prepareContext(current->context, deadline_);
+            Stub& stub = *client_.stubs_[(channel_ + static_cast<std::size_t>(index)) % client_.stubs_.size()];
+            current->reader = (stub.*prepare_)(&current->context, request_, cq_);
+            current->reader->StartCall();
+            current->reader->Finish(&current->response, &current->status, current.get());
+            ++pending_;
+            ++inflight_;
+        }
+
+        void onAttempt(attempt& finished) {
+            bool complete = false;
+            bool release;
+            grpc::Status status;
+            Response response;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --pending_;
+                --inflight_;
+                if (hedge_ && finished.status.ok()) {
+                    client_.recordLatency(std::chrono::steady_clock::now() - finished.started);
+                }
+                // 成功即生效；失败时若另一次尝试仍在进行则等它的结果
+                if (!completed_ && (finished.status.ok() || inflight_ == 0)) {
+                    completed_ = complete = true;
+                    status = finished.status;
+                    response = std::move(finished.response);
+                    if (finished.index == 1 && status.ok()) {
+                        client_.hedge_wins_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    for (auto& other : attempts_) {
+                        if (other && other.get() != &finished) {
+                            other->context.TryCancel();
+                        }
+                    }
+                    if (timer_pending_) {
+                        timer_.alarm.Cancel();
+                    }
+                }
+                release = completed_ && pending_ == 0;
+            }
+            if (complete) {
+                done_(status, std::move(response));
+            }
+            if (release) {
+                client_.untrack(this);
+                delete this;
+            }
+        }
+
+        void onTimer(bool fired) {
+            bool release;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --pending_;
+                timer_pending_ = false;
+                if (fired && !completed_ && !cancelled_ && client_.allowHedge()) {
+                    launch(1);
+                }
+                release = completed_ && pending_ == 0;
+            }
+            if (release) {
+                client_.untrack(this);
+                delete this;
+            }
+        }
+
+        DBClient& client_;
+        PrepareFn<Request, Response> prepare_;
+        const Request request_;
+        Callback<Response> done_;
+        const Clock::time_point deadline_;
+        grpc::CompletionQueue* cq_;
+
+        std::mutex mutex_;
+        std::size_t channel_ = 0;
+        bool hedge_ = false;
+        std::unique_ptr<attempt> attempts_[2];
+        hedgeTimer timer_;
+        bool timer_pending_ = false;
+        bool completed_ = false;
+        bool cancelled_ = false;
+        int pending_ = 0;   // 尚未从完成队列取出的事件
+        int inflight_ = 0;  // 尚未返回的尝试
+    };
+
+    template<typename Request, typename Response>
+    void start(PrepareFn<Request, Response> prepare, const Request& request, Callback<Response> done,
+               std::chrono::milliseconds timeout, bool hedge) {
+        if (hedge) {
+            reads_.fetch_add(1, std::memory_order_relaxed);
+        }
+        grpc::CompletionQueue* cq = queues_[nextIndex(queue_cursor_, queues_.size())].get();
+        auto* call = new unaryCall<Request, Response>(*this, prepare, request, std::move(done),
+                                                      deadlineOf(timeout), cq);
+        {
+            std::lock_guard<std::mutex> lock(calls_mutex_);
+            calls_.insert(call);
+        }
+        call->start(nextIndex(channel_cursor_, stubs_.size()), hedge);
+    }
+
+    // 调用删除前从登记中移除；与析构函数互斥，析构函数取消调用期间调用对象不会被删除
+    void untrack(callBase* call) {
+        std::lock_guard<std::mutex> lock(calls_mutex_);
+        calls_.erase(call);
+    }
+
+    template<typename Response, typename Issue>
+    static std::future<CallResult<Response>> withFuture(Issue&& issue) {
+        auto promise = std::make_shared<std::promise<CallResult<Response>>>();
+        std::future<CallResult<Response>> result = promise->get_future();
+        issue([promise](const grpc::Status& status, Response&& response) {
+            promise->set_value(CallResult<Response>{status, std::move(response)});
+        });
+        return result;
+    }
+
+    static void poll(grpc::CompletionQueue* cq) {
+        void* tag;
+        bool ok;
+        while (cq->Next(&tag, &ok)) {
+            static_cast<completionEvent*>(tag)->proceed(ok);
+        }
+    }
+
+    static std::size_t nextIndex(std::atomic<std::size_t>& cursor, std::size_t size) {
+        return cursor.fetch_add(1, std::memory_order_relaxed) % size;
+    }
+
+    Clock::time_point deadlineOf(std::chrono::milliseconds timeout) const {
+        if (timeout == DEFAULT_DEADLINE) {
+            timeout = std::chrono::milliseconds(options_.deadline_ms);
+        }
+        return timeout.count() > 0 ? Clock::now() + timeout : Clock::time_point::max();
+    }
+
+    void prepareContext(grpc::ClientContext& context, Clock::time_point deadline) const {
+        if (deadline != Clock::time_point::max()) {
+            context.set_deadline(deadline);
+        }
+        if (!options_.session_id.empty()) {
+            context.AddMetadata("x-session-id", options_.session_id);
+        }
+    }
+
+    // 对冲请求不超过读请求数的 hedge_budget（外加少量突发），服务端过载时不会因对冲而加倍负载
+    bool allowHedge() {
+        uint64_t allowed = static_cast<uint64_t>(options_.hedge_budget * static_cast<double>(reads_.load()))
+                           + HEDGE_BURST;
+        uint64_t hedged = hedged_.load(std::memory_order_relaxed);
+        while (hedged < allowed) {
+            if (hedged_.compare_exchange_weak(hedged, hedged + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 对冲延迟取最近 HEDGE_WINDOW 个成功读请求的分位数，随负载变化自动调整
+    void recordLatency(std::chrono::steady_clock::duration elapsed) {
+        latency_.record(elapsed);
+        if (samples_.fetch_add(1, std::memory_order_relaxed) % HEDGE_WINDOW != HEDGE_WINDOW - 1) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(window_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        latencyHistogram::Snapshot current = latency_.snapshot();
+        latencyHistogram::Snapshot window = current;
+        window.count -= previous_.count;
+        for (int i = 0; i < latencyHistogram::BUCKETS; ++i) {
+            window.buckets[i] -= previous_.buckets[i];
+        }
+        previous_ = current;
+        uint64_t delay_us = std::max(hedge_min_delay_us_, window.percentile(options_.hedge_percentile));
+        hedge_delay_us_.store(window.count > 0 ? delay_us : 0, std::memory_order_relaxed);
+    }
+
+    static const int IMPORT_ROWS_PER_MESSAGE = 500;
+    static const uint64_t HEDGE_WINDOW = 1000;
+    static const uint64_t HEDGE_BURST = 10;
+
+    const ClientOptions options_;
+    const uint64_t hedge_min_delay_us_;
+    std::vector<std::unique_ptr<Stub>> stubs_;
+    std::vector<std::unique_ptr<grpc::CompletionQueue>> queues_;
+    std::vector<std::thread> pollers_;
+    std::atomic<std::size_t> channel_cursor_{0};
+    std::atomic<std::size_t> queue_cursor_{0};
+    std::mutex calls_mutex_;
+    std::unordered_set<callBase*> calls_;
+
+    latencyHistogram latency_;
+    std::atomic<uint64_t> samples_{0};
+    std::mutex window_mutex_;
+    latencyHistogram::Snapshot previous_;
+    std::atomic<uint64_t> hedge_delay_us_{0};
+
+    std::atomic<uint64_t> reads_{0};
+    std::atomic<uint64_t> hedged_{0};
+    std::atomic<uint64_t> hedge_wins_{0};
+};
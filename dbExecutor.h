@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// 有界的数据库任务执行器
+// 固定数量的工作线程（与连接池大小一致）执行阻塞的 MySQL 调用，
+// 任务队列有上限，队列满时由调用方决定如何拒绝请求。
+// 队列是构造时一次分配的环形槽位，入队与出队不再分配内存；
+// 捕获不超过两个指针的任务存放在 std::function 内部，提交过程没有堆分配
+class dbExecutor {
+public:
+    dbExecutor(int thread_num, std::size_t max_queue_size)
+        : max_queue_size_(std::max<std::size_t>(1, max_queue_size)), 
+          tasks_(max_queue_size_), stop_(false) {
+        if (thread_num < 1) {
+            thread_num = 1;
+        }
+        for (int i = 0; i < thread_num; ++i) {
+            workers_.emplace_back([this]() { workerLoop(); });
+        }
+        std::cout << "数据库执行器启动: 工作线程 " << thread_num 
+                  << ", 队列上限 " << max_queue_size_ << std::endl;
+    }
+
+    ~dbExecutor() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    dbExecutor(const dbExecutor&) = delete;
+    dbExecutor& operator=(const dbExecutor&) = delete;
+
+    // 提交任务，队列已满或执行器已停止时返回 false
+    bool submit(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_ || size_ >= max_queue_size_) {
+                return false;
+            }
+            tasks_[(head_ + size_) % max_queue_size_] = std::move(task);
+            ++size_;
+        }
+        cond_.notify_one();
+        return true;
+    }
+
+    std::size_t pending() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return stop_ || size_ > 0; });
+                // 停止后仍把已入队的任务执行完，保证每个 RPC 都能得到应答
+                if (size_ == 0) {
+                    return;
+                }
+                task = std::move(tasks_[head_]);
+                tasks_[head_] = nullptr;
+                head_ = (head_ + 1) % max_queue_size_;
+                --size_;
+            }
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "数据库任务执行异常: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    const std::size_t max_queue_size_;
+    std::vector<std::function<void()>> tasks_;  // 环形队列，[head_, head_ + size_) 为待执行的任务
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,252 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+// 对数线性分桶的延迟直方图（HDR 风格，单位微秒，相对误差约 12.5%）
+// 记录只是一次无锁的 relaxed 原子自增
+class latencyHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 40;  // 约 12 天，超出的值计入最后一个桶
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::array<uint64_t, BUCKETS> buckets{};
+
+        // q 取 0-1，返回所在桶的上界
+        uint64_t percentile(double q) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t target = static_cast<uint64_t>(q * static_cast<double>(count));
+            if (target >= count) {
+                target = count - 1;
+            }
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; ++i) {
+                seen += buckets[i];
+                if (seen > target) {
+                    uint64_t upper = bucketUpper(i);
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    void record(uint64_t value_us) {
+        buckets_[bucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value_us, std::memory_order_relaxed);
+        uint64_t prev = max_.load(std::memory_order_relaxed);
+        while (value_us > prev &&
+               !max_.compare_exchange_weak(prev, value_us, std::memory_order_relaxed)) {}
+    }
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record(static_cast<uint64_t>(us < 0 ? 0 : us));
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        for (int i = 0; i < BUCKETS; ++i) {
+            snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.buckets[i];
+        }
+        snapshot.sum = sum_.load(std::memory_order_relaxed);
+        snapshot.max = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    static int bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int msb = 63 - __builtin_clzll(value);
+        if (msb >= MAX_BITS) {
+            return BUCKETS - 1;
+        }
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t bucketUpper(int index) {
+        if (index < SUB_BUCKETS) {
+            return static_cast<uint64_t>(index);
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// 按错误码计数的无锁开放寻址表，槽位用尽后计入 overflow
+class errorCodeCounter {
+public:
+    static constexpr int SLOTS = 64;
+
+    void record(int code) {
+        if (code == 0) {
+            code = -1;  // 0 作为空槽标记，未知错误记为 -1
+        }
+        unsigned start = static_cast<unsigned>(code) % SLOTS;
+        for (int probe = 0; probe < SLOTS; ++probe) {
+            int slot = static_cast<int>((start + probe) % SLOTS);
+            int current = codes_[slot].load(std::memory_order_acquire);
+            if (current == 0) {
+                int expected = 0;
+                if (codes_[slot].compare_exchange_strong(expected, code, std::memory_order_acq_rel)) {
+                    current = code;
+                } else {
+                    current = expected;
+                }
+            }
+            if (current == code) {
+                counts_[slot].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        overflow_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 返回 (错误码, 次数)，overflow 以错误码 0 表示
+    std::vector<std::pair<int, uint64_t>> snapshot() const {
+        std::vector<std::pair<int, uint64_t>> result;
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            int code = codes_[slot].load(std::memory_order_acquire);
+            uint64_t count = counts_[slot].load(std::memory_order_relaxed);
+            if (code != 0 && count > 0) {
+                result.emplace_back(code, count);
+            }
+        }
+        uint64_t overflow = overflow_.load(std::memory_order_relaxed);
+        if (overflow > 0) {
+            result.emplace_back(0, overflow);
+        }
+        return result;
+    }
+
+private:
+    std::array<std::atomic<int>, SLOTS> codes_{};
+    std::array<std::atomic<uint64_t>, SLOTS> counts_{};
+    std::atomic<uint64_t> overflow_{0};
+};
+
+enum class RpcOp : int { Insert = 0, Update, Delete, Batch, Query, GetUser, Import, Count };
+
+// 进程内的数据库与 RPC 指标，记录路径全部为无锁原子操作
+class dbMetrics {
+public:
+    static constexpr int STATUS_CODES = 17;  // grpc::StatusCode 0-16
+    static constexpr int OP_COUNT = static_cast<int>(RpcOp::Count);
+
+    static dbMetrics& getInstance() {
+        static dbMetrics instance;
+        return instance;
+    }
+
+    static const char* opName(RpcOp op) {
+        static const char* names[] = {"insert", "update", "delete", "batch", "query", "get_user", "import"};
+        return names[static_cast<int>(op)];
+    }
+
+    static const char* statusName(int status_code) {
+        static const char* names[STATUS_CODES] = {
+            "OK", "CANCELLED", "UNKNOWN", "INVALID_ARGUMENT", "DEADLINE_EXCEEDED", "NOT_FOUND",
+            "ALREADY_EXISTS", "PERMISSION_DENIED", "RESOURCE_EXHAUSTED", "FAILED_PRECONDITION",
+            "ABORTED", "OUT_OF_RANGE", "UNIMPLEMENTED", "INTERNAL", "UNAVAILABLE", "DATA_LOSS",
+            "UNAUTHENTICATED"};
+        return names[status_code];
+    }
+
+    // op 为 RpcOp::Count（如未知操作类型）时不计入
+    void recordRpc(RpcOp op, int status_code, std::chrono::steady_clock::duration elapsed) {
+        int index = static_cast<int>(op);
+        if (index < 0 || index >= OP_COUNT) {
+            return;
+        }
+        if (status_code < 0 || status_code >= STATUS_CODES) {
+            status_code = 2;  // UNKNOWN
+        }
+        rpc_status_[index][status_code].fetch_add(1, std::memory_order_relaxed);
+        rpc_latency_[index].record(elapsed);
+    }
+
+    uint64_t rpcCount(RpcOp op, int status_code) const {
+        return rpc_status_[static_cast<int>(op)][status_code].load(std::memory_order_relaxed);
+    }
+
+    const latencyHistogram& rpcLatency(RpcOp op) const {
+        return rpc_latency_[static_cast<int>(op)];
+    }
+
+    // 连接池
+    latencyHistogram pool_acquire;      // 获取连接耗时（含等待与扩容建连）
+    std::atomic<uint64_t> pool_acquire_failures{0};  // 超时或扩容建连失败
+    std::atomic<uint64_t> pool_created{0};
+    std::atomic<uint64_t> pool_discarded{0};
+    std::atomic<uint64_t> pool_reconnects{0};
+
+    // 语句执行阶段
+    latencyHistogram prepare_latency;   // 预处理语句缓存未命中时的服务端 prepare
+    latencyHistogram execute_latency;   // 事务或查询回调的执行时间
+    latencyHistogram commit_latency;
+    std::atomic<uint64_t> stmt_cache_hits{0};
+    std::atomic<uint64_t> stmt_cache_misses{0};
+    std::atomic<uint64_t> round_trips{0};  // 与 MySQL 的往返次数
+
+    errorCodeCounter mysql_errors;
+
+private:
+    dbMetrics() = default;
+
+    std::array<std::array<std::atomic<uint64_t>, STATUS_CODES>, OP_COUNT> rpc_status_{};
+    std::array<latencyHistogram, OP_COUNT> rpc_latency_;
+};
+
+// Prometheus 文本格式的辅助输出
+namespace prometheus {
+
+inline void appendValue(std::string& out, const std::string& name, const std::string& labels, double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    out += name;
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+    out += " ";
+    out += buffer;
+    out += "\n";
+}
+
+inline void appendType(std::string& out, const std::string& name, const char* type) {
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+// 直方图以 summary 形式输出（分位数 + _sum + _count）
+inline void appendSummary(std::string& out, const std::string& name, const std::string& labels,
+                          const latencyHistogram::Snapshot& snapshot) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    appendValue(out, name, prefix + "quantile=\"0.5\"", static_cast<double>(snapshot.percentile(0.5)));
+    appendValue(out, name, prefix + "quantile=\"0.9\"", static_cast<double>(snapshot.percentile(0.9)));
+    appendValue(out, name, prefix + "quantile=\"0.99\"", static_cast<double>(snapshot.percentile(0.99)));
+    appendValue(out, name, prefix + "quantile=\"0.999\"", static_cast<double>(snapshot.percentile(0.999)));
+    appendValue(out, name + "_sum", labels, static_cast<double>(snapshot.sum));
+    appendValue(out, name + "_count", labels, static_cast<double>(snapshot.count));
+}
+
+}  // namespace prometheus
@@ -0,0 +1,1381 @@
+#pragma once
+#include "mysqlDao.h"
+#include "mysqlMgr.h"
+#include "serverConfig.h"
+#include "dbExecutor.h"
+#include "arenaAllocator.h"
+#include "groupCommit.h"
+#include "writeBehind.h"
+#include "bulkImport.h"
+#include "userCache.h"
+#include "asyncLogger.h"
+#include "dbMetrics.h"
+#include "concurrencyLimiter.h"
+#include "requestScope.h"
+#include "slowLog.h"
+#include <grpcpp/grpcpp.h>
+#include "mgrMysql.grpc.pb.h"
+#include "mgrMysql.pb.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// gRPC 服务实现：同步的 DBServiceImpl 与走回调 API 的 DBAsyncServiceImpl，由 grpc_server.cpp 注册到服务器。
+// 构造时可以传入现成的 mysqlMgr（如检查程序接入替身驱动），否则按配置连接数据库
+
+using grpc::ServerContext;
+using grpc::CallbackServerContext;
+using grpc::ServerUnaryReactor;
+using grpc::Status;
+using namespace db_operations;
+
+// 记录操作日志，格式化与写盘由 asyncLogger 的后台线程完成
+inline void logOperation(LogOp operation, const UserInfo& user_info, 
+                         bool success, const char* message) {
+    asyncLogger::getInstance().log(operation, success, user_info.name(), user_info.age(), 1, message);
+}
+
+inline void logOperation(LogOp operation, const UserInfo& user_info, 
+                         bool success, const std::string& message) {
+    asyncLogger::getInstance().log(operation, success, user_info.name(), user_info.age(), 1, message);
+}
+
+// 记录批量操作日志
+inline void logBatch(const BatchRequest& request, std::size_t succeeded, 
+                     bool success, const std::string& message) {
+    static const std::string ATOMIC_MODE = "ATOMIC";
+    static const std::string BEST_EFFORT_MODE = "BEST_EFFORT";
+    asyncLogger::getInstance().logBatch(success, 
+        request.mode() == BatchRequest::ATOMIC ? ATOMIC_MODE : BEST_EFFORT_MODE,
+        static_cast<int64_t>(succeeded), request.operations_size(), message);
+}
+
+// 记录查询日志
+inline void logQuery(const QueryRequest& request, std::size_t rows, 
+                     bool success, const std::string& message) {
+    asyncLogger::getInstance().logQuery(success, request.name_prefix(), request.min_age(), 
+                                        request.max_age(), static_cast<int64_t>(rows), message);
+}
+
+// 单条写操作的应答文本，启动时构造一次：成功路径直接引用，不再由字面量临时构造 std::string
+struct WriteText {
+    LogOp operation;
+    std::string ok;
+    std::string fail;
+    std::string deferred;  // 延迟写回模式下的确认
+    const char* status;    // 失败时的 gRPC 状态信息
+};
+
+inline const WriteText INSERT_TEXT{LogOp::Insert, "插入成功", "插入失败", 
+                                   "插入成功, 稍后写回数据库", "Database insert operation failed"};
+inline const WriteText UPDATE_TEXT{LogOp::Update, "更新成功", "更新失败", 
+                                   "更新成功, 稍后写回数据库", "Database update operation failed"};
+inline const WriteText DELETE_TEXT{LogOp::Delete, "删除成功", "删除失败", 
+                                   "删除成功, 稍后写回数据库", "Database delete operation failed"};
+
+inline const WriteText& TextOf(DBRequest::OperationType operation) {
+    switch (operation) {
+        case DBRequest::UPDATE:
+            return UPDATE_TEXT;
+        case DBRequest::DELETE:
+            return DELETE_TEXT;
+        default:
+            return INSERT_TEXT;
+    }
+}
+
+// 同步服务：每个进行中的 RPC 占用一个 gRPC 线程
+class DBServiceImpl : public DBService::Service {
+public:
+    // mgr 为空时按 config.mysql 连接数据库
+    explicit DBServiceImpl(const ServerConfig& config, std::unique_ptr<mysqlMgr> mgr = nullptr) {
+        Init(config, std::move(mgr));
+    }
+
+protected:
+    // 生成的 WithCallbackMethod_* 基类只能默认构造，派生类在自己的构造函数中调用 Init
+    DBServiceImpl() = default;
+
+    void Init(const ServerConfig& config, std::unique_ptr<mysqlMgr> mgr) {
+        try {
+            if (mgr) {
+                mysqlMgr_ = std::move(mgr);
+            } else {
+                mysqlMgr_ = std::make_unique<mysqlMgr>(config.mysql);
+                std::cout << "数据库管理器初始化成功" << std::endl;
+            }
+
+            if (config.group_commit_enabled) {
+                groupCommitter_ = std::make_unique<groupCommitter>(*mysqlMgr_, config.group_commit);
+            }
+            queryPageSize_ = config.grpc.query_page_size;
+            breakerEnabled_ = config.mysql.breaker.enabled;
+
+            if (config.cache_enabled) {
+                userCache_ = std::make_unique<userCache>(config.cache);
+                std::cout << "用户缓存已启用: 容量 " << config.cache.capacity 
+                          << ", TTL " << config.cache.ttl_sec << "s" << std::endl;
+            }
+
+            if (config.limiter_enabled) {
+                limiter_ = std::make_unique<concurrencyLimiter>(config.limiter);
+                std::cout << "自适应并发限制已启用: 初始上限 " << limiter_->limit() << std::endl;
+            }
+
+            importer_ = std::make_unique<bulkImporter>(*mysqlMgr_, config.import,
+                [this](const std::vector<BatchOp>& rows) {
+                    for (const auto& row : rows) {
+                        invalidateCache(row.name);
+                    }
+                });
+
+            if (config.write_behind_enabled) {
+                // 写回 MySQL 之后缓存才与数据库一致，此时再使一次缓存失效
+                writeBehind_ = std::make_unique<writeBehindLog>(*mysqlMgr_, config.write_behind,
+                    [this](const std::vector<BatchOp>& ops) {
+                        for (const auto& op : ops) {
+                            invalidateCache(op.name);
+                        }
+                    });
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "数据库管理器初始化失败: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+public:
+    // 配置热加载：连接池大小与超时、缓存容量与 TTL、流式查询页大小、组提交的窗口与批量、
+    // 并发限制参数立即生效；监听地址、运行模式、数据库地址等只在启动时读取，变更后提示需要重启
+    void ApplyConfig(const ServerConfig& previous, const ServerConfig& next) {
+        mysqlMgr_->reconfigure(next.mysql);
+        queryPageSize_ = next.grpc.query_page_size;
+        if (userCache_) {
+            userCache_->resize(next.cache.capacity, next.cache.ttl_sec);
+        }
+        if (groupCommitter_) {
+            groupCommitter_->reconfigure(next.group_commit);
+        }
+        if (limiter_) {
+            limiter_->reconfigure(next.limiter);
+        }
+
+        std::vector<std::string> restart_needed;
+        if (previous.grpc.host != next.grpc.host || previous.grpc.port != next.grpc.port ||
+            previous.grpc.mode != next.grpc.mode) {
+            restart_needed.push_back("[grpc] host/port/mode");
+        }
+        if (previous.grpc.executor_threads != next.grpc.executor_threads ||
+            previous.grpc.executor_queue_size != next.grpc.executor_queue_size) {
+            restart_needed.push_back("[grpc] executor_threads/executor_queue_size");
+        }
+        // 只读副本按编号逐个比较：名称含 host:port，地址变更后按名称对应不上
+        auto same_address = [](const MysqlEndpoint& before, const MysqlEndpoint& after) {
+            return std::tie(before.host, before.port, before.user, before.password, before.database) ==
+                   std::tie(after.host, after.port, after.user, after.password, after.database);
+        };
+        if (!same_address(previous.mysql.primary, next.mysql.primary)) {
+            restart_needed.push_back("[mysql] 连接地址");
+        }
+        std::size_t replica_count = std::min(previous.mysql.replicas.size(), next.mysql.replicas.size());
+        for (std::size_t i = 0; i < replica_count; ++i) {
+            if (!same_address(previous.mysql.replicas[i], next.mysql.replicas[i])) {
+                restart_needed.push_back("[mysql_replica_" + std::to_string(i + 1) + "] 连接地址");
+            }
+        }
+        if (previous.mysql.replicas.size() != next.mysql.replicas.size()) {
+            restart_needed.push_back("[mysql_replica_N] 只读副本的增减");
+        }
+        if (previous.group_commit_enabled != next.group_commit_enabled ||
+            previous.write_behind_enabled != next.write_behind_enabled ||
+            previous.cache_enabled != next.cache_enabled ||
+            previous.limiter_enabled != next.limiter_enabled) {
+            restart_needed.push_back("group_commit/write_behind/cache/limiter 的开关");
+        }
+        if (previous.group_commit.flushers != next.group_commit.flushers) {
+            restart_needed.push_back("[group_commit] flushers");
+        }
+        if (previous.cache.shards != next.cache.shards) {
+            restart_needed.push_back("[cache] shards");
+        }
+        const ReplicaOptions& replica_before = previous.mysql.replica;
+        const ReplicaOptions& replica_after = next.mysql.replica;
+        if (std::tie(replica_before.health_interval_ms, replica_before.eject_after_failures,
+                     replica_before.readmit_after_successes, replica_before.max_lag_ms) !=
+            std::tie(replica_after.health_interval_ms, replica_after.eject_after_failures,
+                     replica_after.readmit_after_successes, replica_after.max_lag_ms)) {
+            restart_needed.push_back("[replica]");
+        }
+        const BreakerOptions& breaker_before = previous.mysql.breaker;
+        const BreakerOptions& breaker_after = next.mysql.breaker;
+        if (std::tie(breaker_before.enabled, breaker_before.window_ms, breaker_before.min_requests,
+                     breaker_before.failure_ratio, breaker_before.consecutive_failures,
+                     breaker_before.open_ms, breaker_before.max_open_ms, breaker_before.half_open_requests) !=
+            std::tie(breaker_after.enabled, breaker_after.window_ms, breaker_after.min_requests,
+                     breaker_after.failure_ratio, breaker_after.consecutive_failures,
+                     breaker_after.open_ms, breaker_after.max_open_ms, breaker_after.half_open_requests)) {
+            restart_needed.push_back("[breaker]");
+        }
+        const WriteBehindOptions& wal_before = previous.write_behind;
+        const WriteBehindOptions& wal_after = next.write_behind;
+        if (std::tie(wal_before.dir, wal_before.segment_mb, wal_before.max_log_mb, wal_before.sync_window_us,
+                     wal_before.max_batch, wal_before.backpressure_wait_ms) !=
+            std::tie(wal_after.dir, wal_after.segment_mb, wal_after.max_log_mb, wal_after.sync_window_us,
+                     wal_after.max_batch, wal_after.backpressure_wait_ms)) {
+            restart_needed.push_back("[write_behind]");
+        }
+        const ImportOptions& import_before = previous.import;
+        const ImportOptions& import_after = next.import;
+        if (std::tie(import_before.chunk_rows, import_before.loaders, import_before.max_inflight_chunks,
+                     import_before.max_errors) !=
+            std::tie(import_after.chunk_rows, import_after.loaders, import_after.max_inflight_chunks,
+                     import_after.max_errors)) {
+            restart_needed.push_back("[import]");
+        }
+        if (previous.trace.queue_size != next.trace.queue_size) {
+            restart_needed.push_back("[trace] queue_size");
+        }
+        if (previous.metrics.prometheus_port != next.metrics.prometheus_port ||
+            previous.metrics.prometheus_host != next.metrics.prometheus_host) {
+            restart_needed.push_back("[metrics]");
+        }
+        for (const auto& item : restart_needed) {
+            std::cerr << "配置项 " << item << " 已变更, 需要重启才能生效" << std::endl;
+        }
+    }
+
+private:
+    Status HandleInsert(const UserInfo& user_info, DBResponse* response) {
+        try {
+            bool ok = mysqlMgr_->insert(user_info.name(), user_info.age());
+            invalidateCache(user_info.name());
+            if (ok) {
+                response->set_success(true);
+                response->set_message(INSERT_TEXT.ok);
+                logOperation(LogOp::Insert, user_info, true, INSERT_TEXT.ok);
+                return Status::OK;
+            } else {
+                response->set_success(false);
+                response->set_message(INSERT_TEXT.fail);
+                logOperation(LogOp::Insert, user_info, false, INSERT_TEXT.fail);
+                return Status(grpc::StatusCode::INTERNAL, INSERT_TEXT.status);
+            }
+        } catch (const std::exception& e) {
+            response->set_success(false);
+            response->set_message(std::string("插入异常: ") + e.what());
+            logOperation(LogOp::Insert, user_info, false, e.what());
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+    Status HandleUpdate(const UserInfo& user_info, DBResponse* response) {
+        try {
+            bool ok = mysqlMgr_->update(user_info.name(), user_info.age());
+            invalidateCache(user_info.name());
+            if (ok) {
+                response->set_success(true);
+                response->set_message(UPDATE_TEXT.ok);
+                logOperation(LogOp::Update, user_info, true, UPDATE_TEXT.ok);
+                return Status::OK;
+            } else {
+                response->set_success(false);
+                response->set_message(UPDATE_TEXT.fail);
+                logOperation(LogOp::Update, user_info, false, UPDATE_TEXT.fail);
+                return Status(grpc::StatusCode::INTERNAL, UPDATE_TEXT.status);
+            }
+        } catch (const std::exception& e) {
+            response->set_success(false);
+            response->set_message(std::string("更新异常: ") + e.what());
+            logOperation(LogOp::Update, user_info, false, e.what());
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+    Status HandleDelete(const UserInfo& user_info, DBResponse* response) {
+        try {
+            bool ok = mysqlMgr_->deleteData(user_info.name(), user_info.age());
+            invalidateCache(user_info.name());
+            if (ok) {
+                response->set_success(true);
+                response->set_message(DELETE_TEXT.ok);
+                logOperation(LogOp::Delete, user_info, true, DELETE_TEXT.ok);
+                return Status::OK;
+            } else {
+                response->set_success(false);
+                response->set_message(DELETE_TEXT.fail);
+                logOperation(LogOp::Delete, user_info, false, DELETE_TEXT.fail);
+                return Status(grpc::StatusCode::INTERNAL, DELETE_TEXT.status);
+            }
+        } catch (const std::exception& e) {
+            response->set_success(false);
+            response->set_message(std::string("删除异常: ") + e.what());
+            logOperation(LogOp::Delete, user_info, false, e.what());
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+public:
+    Status ExecuteOperation(ServerContext* context, const DBRequest* request,
+                          DBResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        RpcOp op = OpOf(*request);
+        Status rejected;
+        if (!Admit(context, rejected, writeBehind_ ? DbAccess::Local : DbAccess::Write)) {
+            return Observe(op, trace, rejected);
+        }
+        std::string_view session = SessionOf(context);
+        if (writeBehind_ || groupCommitter_) {
+            std::promise<Status> done;
+            std::future<Status> status = done.get_future();
+            requestTrace::Clock::time_point completed;
+            auto finish = [&done, &completed](const Status& result) {
+                completed = requestTrace::Clock::now();
+                done.set_value(result);
+            };
+            auto submitted = requestTrace::Clock::now();
+            if (SubmitWriteBehind(context, request, response, finish) || SubmitGroupCommit(request, response, finish)) {
+                Status result = status.get();
+                TraceDeferred(trace, submitted, completed);
+                return Observe(op, trace, NoteWrite(session, Settle(context, trace.received(), std::move(result))));
+            }
+        }
+        return Observe(op, trace, NoteWrite(session, RunAdmitted(context, trace, [&]() {
+            return Dispatch(request, response);
+        })));
+    }
+
+    Status ExecuteBatch(ServerContext* context, const BatchRequest* request,
+                        BatchResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        Status rejected;
+        if (!Admit(context, rejected)) {
+            return Observe(RpcOp::Batch, trace, rejected);
+        }
+        return Observe(RpcOp::Batch, trace, NoteWrite(SessionOf(context), RunAdmitted(context, trace, [&]() {
+            return HandleBatch(request, response);
+        })));
+    }
+
+    // 流式查询只受截止时间与取消约束，不经过并发限制：单次查询的时长随结果集变化，
+    // 不适合作为延迟样本
+    Status Query(ServerContext* context, const QueryRequest* request,
+                 grpc::ServerWriter<QueryResponse>* writer) override {
+        requestTrace trace(requestTrace::Clock::now());
+        if (!mysqlMgr_->readable()) {
+            return Observe(RpcOp::Query, trace, Unavailable(context, DbAccess::Read));
+        }
+        Status status;
+        {
+            requestScope scope(DeadlineOf(context), [context]() { return context->IsCancelled(); },
+                               Traced(trace));
+            trace.started();
+            status = StreamQuery(context, request, writer);
+            trace.executed(scope.roundTrips());
+        }
+        return Observe(RpcOp::Query, trace, std::move(status));
+    }
+
+    Status GetUser(ServerContext* context, const GetUserRequest* request,
+                   GetUserResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        uint64_t ticket = 0;
+        if (LookupCachedUser(request, response, ticket)) {
+            return Observe(RpcOp::GetUser, trace, Status::OK);
+        }
+        Status rejected;
+        if (!Admit(context, rejected, DbAccess::Read)) {
+            return Observe(RpcOp::GetUser, trace, rejected);
+        }
+        return Observe(RpcOp::GetUser, trace, RunAdmitted(context, trace, [&]() {
+            return LoadUser(request, response, ticket, SessionOf(context));
+        }, DbAccess::Read));
+    }
+
+    // 批量导入同样不经过并发限制：写入并发由 [import] loaders 固定，
+    // 写入跟不上时暂停读取客户端的流。写入在 loader 线程上执行，追踪把读流与写入整体计为 Execute
+    Status Import(ServerContext* context, grpc::ServerReader<ImportRequest>* reader,
+                  ImportResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        if (!mysqlMgr_->writable()) {
+            return Observe(RpcOp::Import, trace, Unavailable(context));
+        }
+        auto started = requestTrace::Clock::now();
+        trace.started(started);
+        Status status = StreamImport(context, reader, response);
+        auto loaded = requestTrace::Clock::now();
+        trace.record(TracePhase::Execute, started, loaded);
+        trace.executed(0, loaded);
+        return Observe(RpcOp::Import, trace, std::move(status));
+    }
+
+    Status GetCacheStats(ServerContext* /*context*/, const CacheStatsRequest* /*request*/,
+                         CacheStatsResponse* response) override {
+        FillCacheStats(response);
+        return Status::OK;
+    }
+
+    Status GetMetrics(ServerContext* /*context*/, const MetricsRequest* request,
+                      MetricsResponse* response) override {
+        dbMetrics& metrics = dbMetrics::getInstance();
+        for (int op = 0; op < dbMetrics::OP_COUNT; ++op) {
+            RpcOp rpc_op = static_cast<RpcOp>(op);
+            OpMetrics* op_metrics = response->add_ops();
+            op_metrics->set_op(dbMetrics::opName(rpc_op));
+            FillLatency(metrics.rpcLatency(rpc_op).snapshot(), op_metrics->mutable_latency());
+            for (int code = 0; code < dbMetrics::STATUS_CODES; ++code) {
+                uint64_t count = metrics.rpcCount(rpc_op, code);
+                if (count > 0) {
+                    StatusCount* status = op_metrics->add_statuses();
+                    status->set_code(dbMetrics::statusName(code));
+                    status->set_count(count);
+                }
+            }
+        }
+
+        mysqlDao::PoolStats pool_stats = mysqlMgr_->poolStats();
+        PoolMetrics* pool = response->mutable_pool();
+        pool->set_total(pool_stats.total);
+        pool->set_idle(pool_stats.idle);
+        pool->set_in_use(pool_stats.total - pool_stats.idle);
+        pool->set_max(pool_stats.max);
+        FillLatency(metrics.pool_acquire.snapshot(), pool->mutable_acquire());
+        pool->set_acquire_failures(metrics.pool_acquire_failures.load(std::memory_order_relaxed));
+        pool->set_created(metrics.pool_created.load(std::memory_order_relaxed));
+        pool->set_discarded(metrics.pool_discarded.load(std::memory_order_relaxed));
+        pool->set_reconnects(metrics.pool_reconnects.load(std::memory_order_relaxed));
+
+        StatementMetrics* statements = response->mutable_statements();
+        FillLatency(metrics.prepare_latency.snapshot(), statements->mutable_prepare());
+        FillLatency(metrics.execute_latency.snapshot(), statements->mutable_execute());
+        FillLatency(metrics.commit_latency.snapshot(), statements->mutable_commit());
+        statements->set_cache_hits(metrics.stmt_cache_hits.load(std::memory_order_relaxed));
+        statements->set_cache_misses(metrics.stmt_cache_misses.load(std::memory_order_relaxed));
+        statements->set_round_trips(metrics.round_trips.load(std::memory_order_relaxed));
+
+        for (const auto& error : metrics.mysql_errors.snapshot()) {
+            MysqlErrorCount* error_count = response->add_mysql_errors();
+            error_count->set_code(error.first);
+            error_count->set_count(error.second);
+        }
+
+        for (const auto& replica_stats : mysqlMgr_->replicaStats()) {
+            ReplicaMetrics* replica = response->add_replicas();
+            replica->set_name(replica_stats.name);
+            replica->set_healthy(replica_stats.healthy);
+            replica->set_outstanding(replica_stats.outstanding);
+            replica->set_reads(replica_stats.reads);
+            replica->set_ejections(replica_stats.ejections);
+            FillBreaker(replica_stats.breaker, replica->mutable_breaker());
+        }
+
+        LimiterMetrics* limiter = response->mutable_limiter();
+        limiter->set_enabled(limiter_ != nullptr);
+        if (limiter_) {
+            limiter->set_limit(limiter_->limit());
+            limiter->set_inflight(limiter_->inflight());
+            limiter->set_rejected(limiter_->rejected());
+            limiter->set_dropped(limiter_->dropped());
+        }
+
+        FillBreaker(mysqlMgr_->breaker().snapshot(), response->mutable_breaker());
+
+        WriteBehindMetrics* write_behind = response->mutable_write_behind();
+        write_behind->set_enabled(writeBehind_ != nullptr);
+        if (writeBehind_) {
+            writeBehindLog::Stats stats = writeBehind_->stats();
+            write_behind->set_backlog(stats.backlog);
+            write_behind->set_durable_lsn(stats.durable_lsn);
+            write_behind->set_applied_lsn(stats.applied_lsn);
+            write_behind->set_log_bytes(stats.log_bytes);
+            write_behind->set_rejected(stats.rejected);
+            write_behind->set_apply_failures(stats.apply_failures);
+            write_behind->set_fsyncs(stats.fsyncs);
+            write_behind->set_apply_retries(stats.apply_retries);
+            write_behind->set_fsync_failures(stats.sync_failures);
+        }
+
+        FillCacheStats(response->mutable_cache());
+        if (request->include_prometheus_text()) {
+            response->set_prometheus_text(RenderPrometheus());
+        }
+        return Status::OK;
+    }
+
+    // 主库连接池预热完成后返回 true，用于切换健康检查状态
+    bool WaitWarmUp(std::chrono::milliseconds timeout) {
+        if (!mysqlMgr_->waitWarmUp(timeout)) {
+            return false;
+        }
+        // 启动时延迟写回日志中留有未写回的操作：重放完成之前数据库中的数据不完整
+        return !writeBehind_ || writeBehind_->waitReplayed(timeout);
+    }
+
+    // Prometheus 文本格式的全部指标，GetMetrics 与 HTTP 抓取端点共用
+    std::string RenderPrometheus() {
+        dbMetrics& metrics = dbMetrics::getInstance();
+        std::string out;
+        out.reserve(16 * 1024);
+
+        prometheus::appendType(out, "mysql_grpc_requests_total", "counter");
+        for (int op = 0; op < dbMetrics::OP_COUNT; ++op) {
+            RpcOp rpc_op = static_cast<RpcOp>(op);
+            for (int code = 0; code < dbMetrics::STATUS_CODES; ++code) {
+                uint64_t count = metrics.rpcCount(rpc_op, code);
+                if (count > 0) {
+                    prometheus::appendValue(out, "mysql_grpc_requests_total",
+                        std::string("op=\"") + dbMetrics::opName(rpc_op) + "\",code=\"" + 
+                        dbMetrics::statusName(code) + "\"", static_cast<double>(count));
+                }
+            }
+        }
+        prometheus::appendType(out, "mysql_grpc_request_latency_us", "summary");
+        for (int op = 0; op < dbMetrics::OP_COUNT; ++op) {
+            RpcOp rpc_op = static_cast<RpcOp>(op);
+            prometheus::appendSummary(out, "mysql_grpc_request_latency_us",
+                std::string("op=\"") + dbMetrics::opName(rpc_op) + "\"", 
+                metrics.rpcLatency(rpc_op).snapshot());
+        }
+
+        mysqlDao::PoolStats pool_stats = mysqlMgr_->poolStats();
+        prometheus::appendType(out, "mysql_pool_connections", "gauge");
+        prometheus::appendValue(out, "mysql_pool_connections", "state=\"idle\"", pool_stats.idle);
+        prometheus::appendValue(out, "mysql_pool_connections", "state=\"in_use\"", 
+                                pool_stats.total - pool_stats.idle);
+        prometheus::appendType(out, "mysql_pool_max_connections", "gauge");
+        prometheus::appendValue(out, "mysql_pool_max_connections", "", pool_stats.max);
+        prometheus::appendType(out, "mysql_pool_acquire_latency_us", "summary");
+        prometheus::appendSummary(out, "mysql_pool_acquire_latency_us", "", metrics.pool_acquire.snapshot());
+        appendCounter(out, "mysql_pool_acquire_failures_total", metrics.pool_acquire_failures);
+        appendCounter(out, "mysql_pool_connections_created_total", metrics.pool_created);
+        appendCounter(out, "mysql_pool_connections_discarded_total", metrics.pool_discarded);
+        appendCounter(out, "mysql_pool_reconnects_total", metrics.pool_reconnects);
+
+        prometheus::appendType(out, "mysql_statement_latency_us", "summary");
+        prometheus::appendSummary(out, "mysql_statement_latency_us", "phase=\"prepare\"", 
+                                  metrics.prepare_latency.snapshot());
+        prometheus::appendSummary(out, "mysql_statement_latency_us", "phase=\"execute\"", 
+                                  metrics.execute_latency.snapshot());
+        prometheus::appendSummary(out, "mysql_statement_latency_us", "phase=\"commit\"", 
+                                  metrics.commit_latency.snapshot());
+        appendCounter(out, "mysql_stmt_cache_hits_total", metrics.stmt_cache_hits);
+        appendCounter(out, "mysql_stmt_cache_misses_total", metrics.stmt_cache_misses);
+        appendCounter(out, "mysql_round_trips_total", metrics.round_trips);
+
+        prometheus::appendType(out, "mysql_errors_total", "counter");
+        for (const auto& error : metrics.mysql_errors.snapshot()) {
+            prometheus::appendValue(out, "mysql_errors_total", 
+                "code=\"" + std::to_string(error.first) + "\"", static_cast<double>(error.second));
+        }
+
+        std::vector<replicaSet::ReplicaStats> replicas = mysqlMgr_->replicaStats();
+        if (!replicas.empty()) {
+            prometheus::appendType(out, "mysql_replica_healthy", "gauge");
+            for (const auto& replica : replicas) {
+                prometheus::appendValue(out, "mysql_replica_healthy", "replica=\"" + replica.name + "\"", 
+                                        replica.healthy ? 1 : 0);
+            }
+            prometheus::appendType(out, "mysql_replica_outstanding", "gauge");
+            for (const auto& replica : replicas) {
+                prometheus::appendValue(out, "mysql_replica_outstanding", "replica=\"" + replica.name + "\"", 
+                                        replica.outstanding);
+            }
+            prometheus::appendType(out, "mysql_replica_reads_total", "counter");
+            for (const auto& replica : replicas) {
+                prometheus::appendValue(out, "mysql_replica_reads_total", "replica=\"" + replica.name + "\"", 
+                                        static_cast<double>(replica.reads));
+            }
+            prometheus::appendType(out, "mysql_replica_ejections_total", "counter");
+            for (const auto& replica : replicas) {
+                prometheus::appendValue(out, "mysql_replica_ejections_total", "replica=\"" + replica.name + "\"", 
+                                        static_cast<double>(replica.ejections));
+            }
+        }
+
+        if (limiter_) {
+            prometheus::appendType(out, "mysql_grpc_concurrency_limit", "gauge");
+            prometheus::appendValue(out, "mysql_grpc_concurrency_limit", "", limiter_->limit());
+            prometheus::appendType(out, "mysql_grpc_inflight_requests", "gauge");
+            prometheus::appendValue(out, "mysql_grpc_inflight_requests", "", limiter_->inflight());
+            prometheus::appendType(out, "mysql_grpc_shed_total", "counter");
+            prometheus::appendValue(out, "mysql_grpc_shed_total", "reason=\"limit\"", 
+                                    static_cast<double>(limiter_->rejected()));
+            prometheus::appendValue(out, "mysql_grpc_shed_total", "reason=\"dropped\"", 
+                                    static_cast<double>(limiter_->dropped()));
+        }
+
+        if (breakerEnabled_) {
+            // 主库与每个副本各一组，以 endpoint 区分
+            std::vector<std::pair<std::string, circuitBreaker::Snapshot>> breakers;
+            breakers.emplace_back("endpoint=\"primary\"", mysqlMgr_->breaker().snapshot());
+            for (const auto& replica : replicas) {
+                breakers.emplace_back("endpoint=\"" + replica.name + "\"", replica.breaker);
+            }
+            prometheus::appendType(out, "mysql_breaker_state", "gauge");
+            for (const auto& breaker : breakers) {
+                prometheus::appendValue(out, "mysql_breaker_state", breaker.first, 
+                                        static_cast<double>(static_cast<int>(breaker.second.state)));
+            }
+            prometheus::appendType(out, "mysql_breaker_rejected_total", "counter");
+            for (const auto& breaker : breakers) {
+                prometheus::appendValue(out, "mysql_breaker_rejected_total", breaker.first, 
+                                        static_cast<double>(breaker.second.rejected));
+            }
+            prometheus::appendType(out, "mysql_breaker_opened_total", "counter");
+            for (const auto& breaker : breakers) {
+                prometheus::appendValue(out, "mysql_breaker_opened_total", breaker.first, 
+                                        static_cast<double>(breaker.second.opened));
+            }
+        }
+
+        slowLog& slow_log = slowLog::getInstance();
+        prometheus::appendType(out, "mysql_grpc_slow_requests_total", "counter");
+        prometheus::appendValue(out, "mysql_grpc_slow_requests_total", "", static_cast<double>(slow_log.recorded()));
+        prometheus::appendType(out, "mysql_grpc_slow_requests_dropped_total", "counter");
+        prometheus::appendValue(out, "mysql_grpc_slow_requests_dropped_total", "", 
+                                static_cast<double>(slow_log.dropped()));
+
+        if (writeBehind_) {
+            writeBehindLog::Stats stats = writeBehind_->stats();
+            prometheus::appendType(out, "mysql_write_behind_backlog", "gauge");
+            prometheus::appendValue(out, "mysql_write_behind_backlog", "", static_cast<double>(stats.backlog));
+            prometheus::appendType(out, "mysql_write_behind_log_bytes", "gauge");
+            prometheus::appendValue(out, "mysql_write_behind_log_bytes", "", static_cast<double>(stats.log_bytes));
+            prometheus::appendType(out, "mysql_write_behind_events_total", "counter");
+            prometheus::appendValue(out, "mysql_write_behind_events_total", "event=\"fsync\"", 
+                                    static_cast<double>(stats.fsyncs));
+            prometheus::appendValue(out, "mysql_write_behind_events_total", "event=\"rejected\"", 
+                                    static_cast<double>(stats.rejected));
+            prometheus::appendValue(out, "mysql_write_behind_events_total", "event=\"apply_failure\"", 
+                                    static_cast<double>(stats.apply_failures));
+            prometheus::appendValue(out, "mysql_write_behind_events_total", "event=\"apply_retry\"", 
+                                    static_cast<double>(stats.apply_retries));
+            prometheus::appendValue(out, "mysql_write_behind_events_total", "event=\"fsync_failure\"", 
+                                    static_cast<double>(stats.sync_failures));
+        }
+
+        if (userCache_) {
+            userCache::Stats stats = userCache_->stats();
+            prometheus::appendType(out, "user_cache_events_total", "counter");
+            prometheus::appendValue(out, "user_cache_events_total", "event=\"hit\"", stats.hits);
+            prometheus::appendValue(out, "user_cache_events_total", "event=\"miss\"", stats.misses);
+            prometheus::appendValue(out, "user_cache_events_total", "event=\"eviction\"", stats.evictions);
+            prometheus::appendValue(out, "user_cache_events_total", "event=\"expiration\"", stats.expirations);
+            prometheus::appendValue(out, "user_cache_events_total", "event=\"invalidation\"", stats.invalidations);
+            prometheus::appendType(out, "user_cache_size", "gauge");
+            prometheus::appendValue(out, "user_cache_size", "", stats.size);
+        }
+        return out;
+    }
+
+protected:
+    // 客户端通过 x-session-id 元数据标识会话，用于读写分离下读到自己的写入
+    // 返回的视图指向调用的元数据，在 RPC 结束前有效
+    static std::string_view SessionOf(const grpc::ServerContextBase* context) {
+        const auto& metadata = context->client_metadata();
+        auto it = metadata.find("x-session-id");
+        if (it == metadata.end()) {
+            return std::string_view();
+        }
+        return std::string_view(it->second.data(), it->second.size());
+    }
+
+    // 客户端的截止时间换算到 steady_clock；未设置截止时间时为 time_point::max()
+    static std::chrono::steady_clock::time_point DeadlineOf(const grpc::ServerContextBase* context) {
+        auto remaining = context->deadline() - std::chrono::system_clock::now();
+        if (remaining > std::chrono::hours(24)) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return std::chrono::steady_clock::now() + 
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining);
+    }
+
+    // 请求需要的数据库：写请求只能走主库，读请求还可以走只读副本，延迟写回只写本地日志
+    enum class DbAccess { Write, Read, Local };
+
+    // 准入控制：客户端已超时或已取消的请求、所需数据库的熔断器已断开时的请求、
+    // 并发达到限制时的请求直接拒绝，不占用执行器与连接。
+    // 返回 true 时调用方必须以 Settle（或 RunAdmitted）结束该请求
+    bool Admit(grpc::ServerContextBase* context, Status& rejected, DbAccess access = DbAccess::Write) {
+        if (DeadlineOf(context) <= std::chrono::steady_clock::now()) {
+            rejected = Status(grpc::StatusCode::DEADLINE_EXCEEDED, "Deadline exceeded before admission");
+            return false;
+        }
+        if (context->IsCancelled()) {
+            rejected = Status(grpc::StatusCode::CANCELLED, "Request cancelled by client");
+            return false;
+        }
+        if ((access == DbAccess::Write && !mysqlMgr_->writable()) ||
+            (access == DbAccess::Read && !mysqlMgr_->readable())) {
+            rejected = Unavailable(context, access);
+            return false;
+        }
+        if (limiter_ && !limiter_->tryAcquire()) {
+            rejected = Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server overloaded, concurrency limit reached");
+            return false;
+        }
+        return true;
+    }
+
+    // 在请求作用域内执行数据库操作：连接等待与语句超时受截止时间约束，
+    // 排队期间客户端已放弃的请求不再执行。trace 自收到请求起计时，数据库层在其中记录各阶段耗时
+    template<typename Func>
+    Status RunAdmitted(grpc::ServerContextBase* context, requestTrace& trace, Func&& func,
+                       DbAccess access = DbAccess::Write) {
+        Status status;
+        {
+            requestScope scope(DeadlineOf(context), [context]() { return context->IsCancelled(); },
+                               Traced(trace));
+            trace.started();
+            if (scope.aborted()) {
+                status = Status(grpc::StatusCode::CANCELLED, "Request abandoned before execution");
+            } else {
+                status = func();
+                // 排队期间熔断器已断开，数据库层没有执行就拒绝了请求
+                if (!status.ok() && scope.unavailable()) {
+                    status = Unavailable(context, access);
+                }
+            }
+            trace.executed(scope.roundTrips());
+        }
+        return Settle(context, trace.received(), std::move(status));
+    }
+
+    // 关闭追踪时不把上下文交给数据库层，各阶段不再读时钟
+    static requestTrace* Traced(requestTrace& trace) {
+        return slowLog::getInstance().enabled() ? &trace : nullptr;
+    }
+
+    // 熔断器断开时的快速失败。UNAVAILABLE 可以安全重试，grpc-retry-pushback-ms 让启用了
+    // 重试策略的客户端等到下一次后台探测之后再试，而不是立刻重试打到已经不可用的数据库上。
+    // 读请求在主库或任一副本恢复时即可执行，取其中最早的一次探测
+    Status Unavailable(grpc::ServerContextBase* context, DbAccess access = DbAccess::Write) {
+        auto retry_after = access == DbAccess::Read ? mysqlMgr_->readRetryAfter() : mysqlMgr_->retryAfter();
+        context->AddTrailingMetadata("grpc-retry-pushback-ms", std::to_string(retry_after.count()));
+        return Status(grpc::StatusCode::UNAVAILABLE, "MySQL unavailable, circuit breaker open");
+    }
+
+    // 结束一个已准入的请求：失败且客户端已超时或已取消时以 DEADLINE_EXCEEDED/CANCELLED 代替原状态；
+    // 归还并发许可，超时与下游排队已满触发收缩，取消的请求不计入延迟样本
+    Status Settle(grpc::ServerContextBase* context, std::chrono::steady_clock::time_point admitted,
+                  Status status) {
+        if (!status.ok()) {
+            if (DeadlineOf(context) <= std::chrono::steady_clock::now()) {
+                status = Status(grpc::StatusCode::DEADLINE_EXCEEDED, "Deadline exceeded");
+            } else if (context->IsCancelled()) {
+                status = Status(grpc::StatusCode::CANCELLED, "Request cancelled by client");
+            }
+        }
+        if (limiter_) {
+            switch (status.error_code()) {
+                case grpc::StatusCode::DEADLINE_EXCEEDED:
+                case grpc::StatusCode::RESOURCE_EXHAUSTED:
+                    limiter_->onDropped();
+                    break;
+                case grpc::StatusCode::CANCELLED:
+                case grpc::StatusCode::UNAVAILABLE:
+                    limiter_->onIgnore();
+                    break;
+                default:
+                    limiter_->onSuccess(std::chrono::steady_clock::now() - admitted);
+                    break;
+            }
+        }
+        return status;
+    }
+
+    // 写请求完成后记录会话，副本追上之前该会话的读请求走主库；原样返回 status
+    Status NoteWrite(std::string_view session, Status status) {
+        mysqlMgr_->noteWrite(session);
+        return status;
+    }
+
+    static RpcOp OpOf(const DBRequest& request) {
+        switch (request.operation()) {
+            case DBRequest::INSERT:
+                return RpcOp::Insert;
+            case DBRequest::UPDATE:
+                return RpcOp::Update;
+            case DBRequest::DELETE:
+                return RpcOp::Delete;
+            default:
+                return RpcOp::Count;
+        }
+    }
+
+    // 记录一次 RPC 的端到端延迟（自进入处理函数起，含排队）与状态码，原样返回 status；
+    // 同时结束请求的追踪：超过慢请求阈值或被抽中的请求写入慢请求日志。
+    // 每个 RPC 在处理函数入口创建追踪上下文，被拒绝的请求同样经过这里
+    static Status Observe(RpcOp op, requestTrace& trace, Status status) {
+        auto now = std::chrono::steady_clock::now();
+        trace.finish(now);
+        int code = static_cast<int>(status.error_code());
+        dbMetrics::getInstance().recordRpc(op, code, now - trace.received());
+        slowLog::getInstance().submit(op, code, trace);
+        return status;
+    }
+
+    // 组提交与延迟写回的写入由其他线程执行：交出之前计为 Queue，等待批次提交或日志落盘计为 Commit，
+    // 之后到应答计为 Response
+    static void TraceDeferred(requestTrace& trace, requestTrace::Clock::time_point submitted,
+                              requestTrace::Clock::time_point completed) {
+        trace.started(submitted);
+        trace.record(TracePhase::Commit, submitted, completed);
+        trace.executed(0, completed);
+    }
+
+    static void FillLatency(const latencyHistogram::Snapshot& snapshot, LatencySummary* summary) {
+        summary->set_count(snapshot.count);
+        summary->set_sum_us(snapshot.sum);
+        summary->set_p50_us(snapshot.percentile(0.5));
+        summary->set_p90_us(snapshot.percentile(0.9));
+        summary->set_p99_us(snapshot.percentile(0.99));
+        summary->set_p999_us(snapshot.percentile(0.999));
+        summary->set_max_us(snapshot.max);
+    }
+
+    void FillBreaker(const circuitBreaker::Snapshot& snapshot, BreakerMetrics* breaker) const {
+        breaker->set_enabled(breakerEnabled_);
+        breaker->set_state(circuitBreaker::stateName(snapshot.state));
+        breaker->set_rejected(snapshot.rejected);
+        breaker->set_opened(snapshot.opened);
+        breaker->set_retry_after_ms(snapshot.retry_after.count());
+    }
+
+    static void appendCounter(std::string& out, const std::string& name, 
+                              const std::atomic<uint64_t>& counter) {
+        prometheus::appendType(out, name, "counter");
+        prometheus::appendValue(out, name, "", static_cast<double>(counter.load(std::memory_order_relaxed)));
+    }
+
+    void FillCacheStats(CacheStatsResponse* response) {
+        response->set_enabled(userCache_ != nullptr);
+        if (userCache_) {
+            userCache::Stats stats = userCache_->stats();
+            response->set_hits(stats.hits);
+            response->set_misses(stats.misses);
+            response->set_evictions(stats.evictions);
+            response->set_expirations(stats.expirations);
+            response->set_invalidations(stats.invalidations);
+            response->set_size(stats.size);
+        }
+    }
+
+    // 批量导入：逐条读取客户端流交给 bulkImporter，结束后汇总写入结果与出错的行
+    Status StreamImport(ServerContext* context, grpc::ServerReader<ImportRequest>* reader,
+                        ImportResponse* response) {
+        auto deadline = DeadlineOf(context);
+        bulkImporter::Result result;
+        {
+            bulkImporter::session session(*importer_, deadline, [context]() { return context->IsCancelled(); });
+            ImportRequest request;
+            while (reader->Read(&request)) {
+                for (const auto& row : request.rows()) {
+                    session.add(row.name(), row.age());
+                }
+            }
+            result = session.finish();
+        }
+
+        response->set_received(result.received);
+        response->set_inserted(result.inserted);
+        response->set_failed(result.failed);
+        for (const auto& error : result.errors) {
+            ImportRowError* row_error = response->add_errors();
+            row_error->set_index(error.index);
+            row_error->mutable_row()->set_name(error.name);
+            row_error->mutable_row()->set_age(error.age);
+            row_error->set_message(error.message);
+        }
+        std::cout << "批量导入完成: 收到 " << result.received << " 条, 写入 " << result.inserted 
+                  << " 条, 失败 " << result.failed << " 条" << std::endl;
+
+        if (context->IsCancelled()) {
+            return Status(grpc::StatusCode::CANCELLED, "Import cancelled by client");
+        }
+        if (deadline <= std::chrono::steady_clock::now()) {
+            return Status(grpc::StatusCode::DEADLINE_EXCEEDED, "Import deadline exceeded");
+        }
+        return Status::OK;
+    }
+
+    // 流式查询：按页从 MySQL 读取，每页读完即归还连接再逐行写给客户端，
+    // 内存占用只与 query_page_size 有关，每行附带可续传的游标
+    Status StreamQuery(ServerContext* context, const QueryRequest* request,
+                       grpc::ServerWriter<QueryResponse>* writer) {
+        QueryFilter filter;
+        filter.name_prefix = request->name_prefix();
+        filter.min_age = request->min_age();
+        filter.max_age = request->max_age();
+
+        KeysetCursor cursor;
+        if (request->has_after()) {
+            cursor.valid = true;
+            cursor.name = request->after().last_name();
+            cursor.age = request->after().last_age();
+            cursor.id = request->after().last_id();
+        }
+
+        std::string_view session = SessionOf(context);
+        long long remaining = request->limit() > 0 ? request->limit() : -1;
+        std::size_t sent = 0;
+        std::vector<UserRow> rows;
+        int page_size = queryPageSize_.load(std::memory_order_relaxed);
+        rows.reserve(static_cast<std::size_t>(page_size));
+        QueryResponse response;
+
+        while (remaining != 0) {
+            if (context->IsCancelled()) {
+                logQuery(*request, sent, false, "客户端已取消");
+                return Status(grpc::StatusCode::CANCELLED, "Query cancelled by client");
+            }
+
+            int page = remaining > 0 ? static_cast<int>(std::min<long long>(remaining, page_size))
+                                     : page_size;
+            if (!mysqlMgr_->queryPage(filter, cursor, page, rows, session)) {
+                const requestScope* scope = requestScope::current();
+                if (scope && scope->expired()) {
+                    logQuery(*request, sent, false, "请求已超时");
+                    return Status(grpc::StatusCode::DEADLINE_EXCEEDED, "Deadline exceeded during query");
+                }
+                if (scope && scope->unavailable()) {
+                    logQuery(*request, sent, false, "数据库不可用");
+                    return Unavailable(context, DbAccess::Read);
+                }
+                logQuery(*request, sent, false, "查询失败");
+                return Status(grpc::StatusCode::INTERNAL, "Database query failed");
+            }
+
+            for (auto& row : rows) {
+                cursor.valid = true;
+                cursor.name = row.name;
+                cursor.age = row.age;
+                cursor.id = row.id;
+                response.mutable_cursor()->set_last_name(cursor.name);
+                response.mutable_cursor()->set_last_age(cursor.age);
+                response.mutable_cursor()->set_last_id(cursor.id);
+                response.mutable_user_info()->set_name(std::move(row.name));
+                response.mutable_user_info()->set_age(row.age);
+                if (!writer->Write(response)) {
+                    logQuery(*request, sent, false, "客户端连接已断开");
+                    return Status(grpc::StatusCode::CANCELLED, "Client stream closed");
+                }
+                ++sent;
+            }
+
+            if (remaining > 0) {
+                remaining -= static_cast<long long>(rows.size());
+            }
+            if (rows.size() < static_cast<std::size_t>(page)) {
+                break;
+            }
+        }
+
+        logQuery(*request, sent, true, "查询完成");
+        return Status::OK;
+    }
+
+    static void FillUsers(const std::string& name, const std::vector<int>& ages, 
+                          GetUserResponse* response) {
+        response->set_found(!ages.empty());
+        for (int age : ages) {
+            UserInfo* user = response->add_users();
+            user->set_name(name);
+            user->set_age(age);
+        }
+    }
+
+    // 缓存命中时直接填充应答；未命中时 ticket 交给 LoadUser 回填使用
+    bool LookupCachedUser(const GetUserRequest* request, GetUserResponse* response, 
+                          uint64_t& ticket) {
+        if (!userCache_) {
+            return false;
+        }
+        std::vector<int> ages;
+        if (!userCache_->get(request->name(), ages, ticket)) {
+            return false;
+        }
+        FillUsers(request->name(), ages, response);
+        return true;
+    }
+
+    Status LoadUser(const GetUserRequest* request, GetUserResponse* response, uint64_t ticket,
+                    std::string_view session) {
+        try {
+            std::vector<int> ages;
+            bool from_replica = false;
+            if (!mysqlMgr_->findByName(request->name(), ages, session, &from_replica)) {
+                return Status(grpc::StatusCode::INTERNAL, "Database lookup failed");
+            }
+            FillUsers(request->name(), ages, response);
+            if (userCache_) {
+                userCache_->putIfFresh(request->name(), std::move(ages), ticket, from_replica);
+            }
+            return Status::OK;
+        } catch (const std::exception& e) {
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+    void invalidateCache(const std::string& name) {
+        if (userCache_) {
+            userCache_->invalidate(name);
+        }
+    }
+
+    // 单条写操作转换为 BatchOp，不是写操作时返回 false
+    static bool ToBatchOp(const DBRequest& request, BatchOp& op) {
+        switch (request.operation()) {
+            case DBRequest::INSERT:
+                op.type = BatchOp::Type::Insert;
+                break;
+            case DBRequest::UPDATE:
+                op.type = BatchOp::Type::Update;
+                break;
+            case DBRequest::DELETE:
+                op.type = BatchOp::Type::Delete;
+                break;
+            default:
+                return false;
+        }
+        op.name = request.user_info().name();
+        op.age = request.user_info().age();
+        return true;
+    }
+
+    // 开启延迟写回时，写操作追加到本地日志、落盘后即确认，之后由后台线程写回 MySQL。
+    // 客户端得到的是"已持久化到本地"的确认：更新或删除未命中记录、写回时违反约束等错误不再返回给客户端；
+    // 写回之前读请求（包括同一会话）读不到这次写入。返回 false 表示该请求不走延迟写回
+    bool SubmitWriteBehind(grpc::ServerContextBase* context, const DBRequest* request, DBResponse* response,
+                           std::function<void(const Status&)> finish) {
+        BatchOp op;
+        if (!writeBehind_ || !ToBatchOp(*request, op)) {
+            return false;
+        }
+
+        bool queued = writeBehind_->submit(op, [this, request, response, finish](bool durable) {
+            invalidateCache(request->user_info().name());
+            BatchOpResult result{durable, durable ? std::string() : std::string("写入本地日志失败")};
+            Status status = CompleteWrite(*request, result, response);
+            if (durable) {
+                response->set_message(TextOf(request->operation()).deferred);
+            }
+            finish(status);
+        });
+        if (!queued) {
+            // 写回落后太多，日志已满：通过并发限制与 RESOURCE_EXHAUSTED 让客户端退避；
+            // 主库熔断器断开时积压无法写回，按不可用拒绝，客户端等到下一次探测之后再试
+            response->set_success(false);
+            response->set_message("服务繁忙，请稍后重试");
+            finish(mysqlMgr_->writable() ? Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Write-behind log is full")
+                                         : Unavailable(context));
+        }
+        return true;
+    }
+
+    // 开启组提交时，写操作交给 groupCommitter 与其他并发写入合并提交，
+    // finish 在批次提交后被调用；返回 false 表示该请求不走组提交
+    bool SubmitGroupCommit(const DBRequest* request, DBResponse* response,
+                           std::function<void(const Status&)> finish) {
+        BatchOp op;
+        if (!groupCommitter_ || !ToBatchOp(*request, op)) {
+            return false;
+        }
+
+        bool queued = groupCommitter_->submit(std::move(op), 
+            [this, request, response, finish](const BatchOpResult& result) {
+                invalidateCache(request->user_info().name());
+                finish(CompleteWrite(*request, result, response));
+            });
+        if (!queued) {
+            response->set_success(false);
+            response->set_message("服务繁忙，请稍后重试");
+            finish(Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Group commit queue is full"));
+        }
+        return true;
+    }
+
+    // 按单条写操作的约定填充组提交的结果
+    static Status CompleteWrite(const DBRequest& request, const BatchOpResult& result, 
+                                DBResponse* response) {
+        const WriteText& text = TextOf(request.operation());
+        response->set_success(result.success);
+        if (result.success) {
+            response->set_message(text.ok);
+            logOperation(text.operation, request.user_info(), true, text.ok);
+            return Status::OK;
+        }
+        response->set_message(text.fail + ": " + result.message);
+        logOperation(text.operation, request.user_info(), false, result.message);
+        return Status(grpc::StatusCode::INTERNAL, text.status);
+    }
+
+    Status HandleBatch(const BatchRequest* request, BatchResponse* response) {
+        try {
+            if (request->operations_size() > MAX_BATCH_OPS) {
+                response->set_success(false);
+                response->set_message("批量操作数超过上限");
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, "Too many operations in batch");
+            }
+
+            std::vector<BatchOp> ops;
+            ops.reserve(request->operations_size());
+            for (const auto& op : request->operations()) {
+                BatchOp batch_op;
+                switch (op.operation()) {
+                    case DBRequest::INSERT:
+                        batch_op.type = BatchOp::Type::Insert;
+                        break;
+                    case DBRequest::UPDATE:
+                        batch_op.type = BatchOp::Type::Update;
+                        break;
+                    case DBRequest::DELETE:
+                        batch_op.type = BatchOp::Type::Delete;
+                        break;
+                    default:
+                        response->set_success(false);
+                        response->set_message("批量操作中包含未知操作类型");
+                        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown operation type in batch");
+                }
+                batch_op.name = op.user_info().name();
+                batch_op.age = op.user_info().age();
+                ops.push_back(std::move(batch_op));
+            }
+
+            std::vector<BatchOpResult> results;
+            bool atomic = request->mode() == BatchRequest::ATOMIC;
+            bool committed = mysqlMgr_->executeBatch(ops, atomic, results);
+            for (const auto& op : ops) {
+                invalidateCache(op.name);
+            }
+
+            std::size_t succeeded = 0;
+            response->mutable_results()->Reserve(static_cast<int>(results.size()));
+            for (const auto& result : results) {
+                DBResponse* op_response = response->add_results();
+                op_response->set_success(result.success);
+                op_response->set_message(result.message);
+                succeeded += result.success ? 1 : 0;
+            }
+
+            // 批量结果通过 results 返回给客户端，因此部分失败时仍返回 OK
+            response->set_success(committed && succeeded == results.size());
+            if (!committed) {
+                response->set_message("批量事务已回滚");
+            } else if (succeeded == results.size()) {
+                response->set_message("批量执行成功");
+            } else {
+                response->set_message("批量执行部分失败");
+            }
+            logBatch(*request, committed ? succeeded : 0, response->success(), response->message());
+            return Status::OK;
+        } catch (const std::exception& e) {
+            response->set_success(false);
+            response->set_message(std::string("批量操作异常: ") + e.what());
+            logBatch(*request, 0, false, e.what());
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+    Status Dispatch(const DBRequest* request, DBResponse* response) {
+        try {
+            const UserInfo& user_info = request->user_info();
+            
+            switch(request->operation()) {
+                case DBRequest::INSERT:
+                    return HandleInsert(user_info, response);
+                case DBRequest::UPDATE:
+                    return HandleUpdate(user_info, response);
+                case DBRequest::DELETE:
+                    return HandleDelete(user_info, response);
+                default:
+                    response->set_success(false);
+                    response->set_message("未知操作类型");
+                    return Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown operation type");
+            }
+        } catch (const std::exception& e) {
+            response->set_success(false);
+            response->set_message(std::string("操作异常: ") + e.what());
+            return Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+    }
+
+    static const int MAX_BATCH_OPS = 10000;
+    std::atomic<int> queryPageSize_{500};
+    bool breakerEnabled_ = true;
+
+    std::unique_ptr<mysqlMgr> mysqlMgr_;
+    std::unique_ptr<userCache> userCache_;
+    std::unique_ptr<concurrencyLimiter> limiter_;
+    // 以下三者析构时等待后台线程处理完剩余的操作，回调会访问 mysqlMgr_、userCache_ 与 limiter_，
+    // 因此声明在三者之后、先于三者析构
+    std::unique_ptr<groupCommitter> groupCommitter_;
+    std::unique_ptr<writeBehindLog> writeBehind_;
+    std::unique_ptr<bulkImporter> importer_;
+};
+
+// 异步服务：ExecuteOperation/ExecuteBatch 走回调 API，请求交给与连接池等大的执行器，
+// gRPC 线程不再阻塞在 MySQL 调用上，少量线程即可挂起大量待处理的 RPC。
+// 请求与应答分配在每次调用独占、可复用的 arena 上（arenaMessageAllocator），
+// 交给执行器的调用状态也放在同一 arena 上，成功路径上不再有堆分配
+class DBAsyncServiceImpl final 
+    : public DBService::WithCallbackMethod_ExecuteOperation<
+          DBService::WithCallbackMethod_ExecuteBatch<
+          DBService::WithCallbackMethod_GetUser<DBServiceImpl>>> {
+public:
+    // mgr 为空时按 config.mysql 连接数据库；执行器线程数默认与连接池上限相同
+    explicit DBAsyncServiceImpl(const ServerConfig& config, std::unique_ptr<mysqlMgr> mgr = nullptr) {
+        Init(config, std::move(mgr));
+        const GrpcOptions& grpc = config.grpc;
+        executor_ = std::make_unique<dbExecutor>(
+            grpc.executor_threads > 0 ? grpc.executor_threads : mysqlMgr_->poolSize(),
+            static_cast<std::size_t>(std::max(1, grpc.executor_queue_size)));
+        SetMessageAllocatorFor_ExecuteOperation(&operationAllocator_);
+        SetMessageAllocatorFor_ExecuteBatch(&batchAllocator_);
+        SetMessageAllocatorFor_GetUser(&getUserAllocator_);
+    }
+
+    ServerUnaryReactor* ExecuteOperation(CallbackServerContext* context, 
+                                         const DBRequest* request,
+                                         DBResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        RpcOp op = OpOf(*request);
+        ServerUnaryReactor* reactor = context->DefaultReactor();
+        Status rejected;
+        if (!Admit(context, rejected, writeBehind_ ? DbAccess::Local : DbAccess::Write)) {
+            reactor->Finish(Observe(op, trace, rejected));
+            return reactor;
+        }
+        if (writeBehind_ || groupCommitter_) {
+            // 结束回调在写回或组提交线程上执行，context/request/response 在 Finish 之前一直有效；
+            // 追踪上下文放在请求所在的 arena 上随调用释放，请求不在 arena 上时由回调持有
+            requestTrace* deferred = nullptr;
+            std::shared_ptr<requestTrace> owned;
+            if (google::protobuf::Arena* arena = request->GetArena()) {
+                deferred = google::protobuf::Arena::Create<requestTrace>(arena, trace);
+            } else {
+                owned = std::make_shared<requestTrace>(trace);
+                deferred = owned.get();
+            }
+            auto submitted = requestTrace::Clock::now();
+            auto finish = [this, context, reactor, op, deferred, owned, submitted](const Status& status) {
+                TraceDeferred(*deferred, submitted, requestTrace::Clock::now());
+                reactor->Finish(Observe(op, *deferred, NoteWrite(SessionOf(context), 
+                    Settle(context, deferred->received(), status))));
+            };
+            if (SubmitWriteBehind(context, request, response, finish) || SubmitGroupCommit(request, response, finish)) {
+                return reactor;
+            }
+        }
+        using Call = PendingCall<DBRequest, DBResponse>;
+        bool queued = SubmitCall(Call{context, reactor, request, response, trace, 0}, 
+                                 [this](Call& call) {
+            RpcOp op = OpOf(*call.request);
+            call.reactor->Finish(Observe(op, call.trace, NoteWrite(SessionOf(call.context), 
+                RunAdmitted(call.context, call.trace, [&]() {
+                    return Dispatch(call.request, call.response);
+                }))));
+        });
+        if (!queued) {
+            response->set_success(false);
+            response->set_message("服务繁忙，请稍后重试");
+            reactor->Finish(Observe(op, trace, Settle(context, trace.received(),
+                Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "DB executor queue is full"))));
+        }
+        return reactor;
+    }
+
+    ServerUnaryReactor* ExecuteBatch(CallbackServerContext* context,
+                                     const BatchRequest* request,
+                                     BatchResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        ServerUnaryReactor* reactor = context->DefaultReactor();
+        Status rejected;
+        if (!Admit(context, rejected)) {
+            reactor->Finish(Observe(RpcOp::Batch, trace, rejected));
+            return reactor;
+        }
+        using Call = PendingCall<BatchRequest, BatchResponse>;
+        bool queued = SubmitCall(Call{context, reactor, request, response, trace, 0}, 
+                                 [this](Call& call) {
+            call.reactor->Finish(Observe(RpcOp::Batch, call.trace, NoteWrite(SessionOf(call.context), 
+                RunAdmitted(call.context, call.trace, [&]() {
+                    return HandleBatch(call.request, call.response);
+                }))));
+        });
+        if (!queued) {
+            response->set_success(false);
+            response->set_message("服务繁忙，请稍后重试");
+            reactor->Finish(Observe(RpcOp::Batch, trace, Settle(context, trace.received(),
+                Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "DB executor queue is full"))));
+        }
+        return reactor;
+    }
+
+    // 缓存命中直接在 gRPC 线程上完成，未命中才交给执行器访问数据库
+    ServerUnaryReactor* GetUser(CallbackServerContext* context,
+                                const GetUserRequest* request,
+                                GetUserResponse* response) override {
+        requestTrace trace(requestTrace::Clock::now());
+        ServerUnaryReactor* reactor = context->DefaultReactor();
+        uint64_t ticket = 0;
+        if (LookupCachedUser(request, response, ticket)) {
+            reactor->Finish(Observe(RpcOp::GetUser, trace, Status::OK));
+            return reactor;
+        }
+        Status rejected;
+        if (!Admit(context, rejected, DbAccess::Read)) {
+            reactor->Finish(Observe(RpcOp::GetUser, trace, rejected));
+            return reactor;
+        }
+        using Call = PendingCall<GetUserRequest, GetUserResponse>;
+        bool queued = SubmitCall(Call{context, reactor, request, response, trace, ticket}, 
+                                 [this](Call& call) {
+            call.reactor->Finish(Observe(RpcOp::GetUser, call.trace, RunAdmitted(call.context, call.trace, [&]() {
+                return LoadUser(call.request, call.response, call.ticket, SessionOf(call.context));
+            }, DbAccess::Read)));
+        });
+        if (!queued) {
+            reactor->Finish(Observe(RpcOp::GetUser, trace, Settle(context, trace.received(),
+                Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "DB executor queue is full"))));
+        }
+        return reactor;
+    }
+
+private:
+    // 排队等待执行器的一次调用；trace 自收到请求起计时，ticket 只有 GetUser 使用
+    template <typename Request, typename Response>
+    struct PendingCall {
+        CallbackServerContext* context;
+        ServerUnaryReactor* reactor;
+        const Request* request;
+        Response* response;
+        requestTrace trace;
+        uint64_t ticket;
+    };
+
+    // 调用状态放在请求所在的 arena 上，随 RPC 结束一起释放，任务只捕获 this 与一个指针，
+    // 装进 std::function 时不再分配内存；请求不在 arena 上时退回按值捕获
+    template <typename Call, typename Run>
+    bool SubmitCall(const Call& call, Run run) {
+        google::protobuf::Arena* arena = call.request->GetArena();
+        if (arena) {
+            Call* pending = google::protobuf::Arena::Create<Call>(arena, call);
+            return executor_->submit([run, pending]() { run(*pending); });
+        }
+        return executor_->submit([run, pending = call]() mutable { run(pending); });
+    }
+
+    // 分配器必须比执行器中的任务活得久
+    arenaMessageAllocator<DBRequest, DBResponse> operationAllocator_;
+    arenaMessageAllocator<BatchRequest, BatchResponse> batchAllocator_;
+    arenaMessageAllocator<GetUserRequest, GetUserResponse> getUserAllocator_;
+    std::unique_ptr<dbExecutor> executor_;
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include "mysqlMgr.h"
+#include <iostream>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+// 组提交参数，对应 config.ini 的 [group_commit] 部分
+struct GroupCommitOptions {
+    int window_us = 2000;     // window_us: 首条写入到达后最多等待多久凑批
+    int max_batch = 128;      // max_batch: 单个事务最多合并的写操作数
+    int flushers = 2;         // flushers: 并行提交的线程数
+    int max_pending = 10000;  // max_pending: 排队等待提交的写操作上限
+};
+
+// 组提交：把同一时间窗口内到达的单条写操作合并到一个事务中提交，
+// 每批只需一次 commit（一次 fsync），再把各自的结果回调给等待中的 RPC
+class groupCommitter {
+public:
+    using Callback = std::function<void(const BatchOpResult&)>;
+
+    groupCommitter(mysqlMgr& mgr, const GroupCommitOptions& options)
+        : mgr_(mgr), 
+          stop_(false) {
+        reconfigure(options);
+        int flushers = std::max(1, options.flushers);
+        for (int i = 0; i < flushers; ++i) {
+            flushers_.emplace_back([this]() { flushLoop(); });
+        }
+        std::cout << "组提交已启用: 窗口 " << options.window_us << "us, 每批最多 " 
+                  << options.max_batch << " 条, 提交线程 " << flushers << std::endl;
+    }
+
+    // 热加载：凑批窗口、每批上限与排队上限对之后凑的批次生效；提交线程数只在启动时读取
+    void reconfigure(const GroupCommitOptions& options) {
+        window_us_.store(std::max(0, options.window_us), std::memory_order_relaxed);
+        max_batch_.store(static_cast<std::size_t>(std::max(1, options.max_batch)), std::memory_order_relaxed);
+        max_pending_.store(static_cast<std::size_t>(std::max(1, options.max_pending)), std::memory_order_relaxed);
+    }
+
+    ~groupCommitter() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& flusher : flushers_) {
+            if (flusher.joinable()) {
+                flusher.join();
+            }
+        }
+    }
+
+    groupCommitter(const groupCommitter&) = delete;
+    groupCommitter& operator=(const groupCommitter&) = delete;
+
+    // 提交一条写操作，done 在所属批次提交后于提交线程中调用；
+    // 排队已满时返回 false，done 不会被调用
+    bool submit(BatchOp op, Callback done) {
+        std::size_t size;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_ || pending_.size() >= max_pending_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            pending_.push_back(Pending{std::move(op), std::move(done), std::chrono::steady_clock::now()});
+            size = pending_.size();
+        }
+        if (size == 1) {
+            cond_.notify_one();
+        } else if (size >= max_batch_.load(std::memory_order_relaxed)) {
+            cond_.notify_all();
+        }
+        return true;
+    }
+
+private:
+    struct Pending {
+        BatchOp op;
+        Callback done;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void flushLoop() {
+        std::vector<Pending> batch;
+        std::vector<BatchOp> ops;
+        std::vector<BatchOpResult> results;
+        batch.reserve(max_batch_.load(std::memory_order_relaxed));
+        ops.reserve(max_batch_.load(std::memory_order_relaxed));
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+                if (pending_.empty()) {
+                    return;
+                }
+
+                // 以队首写操作的到达时间为起点凑批，凑满或窗口到期即提交
+                std::size_t max_batch = max_batch_.load(std::memory_order_relaxed);
+                auto deadline = pending_.front().enqueued + 
+                                std::chrono::microseconds(window_us_.load(std::memory_order_relaxed));
+                while (!stop_ && !pending_.empty() && pending_.size() < max_batch &&
+                       cond_.wait_until(lock, deadline) != std::cv_status::timeout) {}
+                if (pending_.empty()) {
+                    continue;  // 已被其他提交线程取走
+                }
+
+                std::size_t count = std::min(max_batch, pending_.size());
+                for (std::size_t i = 0; i < count; ++i) {
+                    batch.push_back(std::move(pending_.front()));
+                    pending_.pop_front();
+                }
+                if (!pending_.empty()) {
+                    cond_.notify_one();  // 剩余的写操作交给下一个提交线程
+                }
+            }
+
+            for (auto& pending : batch) {
+                ops.push_back(pending.op);
+            }
+
+            try {
+                // 尽力模式：单条失败不影响同批其他写操作
+                mgr_.executeBatch(ops, false, results);
+            } catch (const std::exception& e) {
+                results.assign(ops.size(), BatchOpResult{false, std::string("组提交异常: ") + e.what()});
+            }
+
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                try {
+                    batch[i].done(results[i]);
+                } catch (const std::exception& e) {
+                    std::cerr << "组提交回调异常: " << e.what() << std::endl;
+                }
+            }
+            batch.clear();
+            ops.clear();
+        }
+    }
+
+    mysqlMgr& mgr_;
+    std::atomic<int> window_us_{0};
+    std::atomic<std::size_t> max_batch_{1};
+    std::atomic<std::size_t> max_pending_{1};
+    bool stop_;
+    std::deque<Pending> pending_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::thread> flushers_;
+};
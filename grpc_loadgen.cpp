@@ -0,0 +1,309 @@
+#include "dbClient.h"
+#include "dbMetrics.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using grpc::Status;
+using namespace db_operations;
+using Clock = std::chrono::steady_clock;
+
+// 压测参数，均可通过 --key=value 覆盖
+struct LoadgenOptions {
+    std::string target = "localhost:50051";
+    int channels = 4;          // 独立的 HTTP/2 连接数
+    int concurrency = 16;      // 每个连接上同时进行的 RPC 数（闭环）或上限（开环）
+    double rate = 0;           // 开环模式的目标 QPS，0 表示闭环：完成一个立即发下一个
+    double duration_sec = 10;
+    double warmup_sec = 2;     // 预热期内的请求不计入结果
+    int insert_weight = 50;    // --mix=50:30:20 依次为 INSERT:UPDATE:DELETE 权重
+    int update_weight = 30;
+    int delete_weight = 20;
+    uint64_t keys = 100000;    // name 取值空间 user_0 ... user_{keys-1}
+    std::string dist = "uniform";  // uniform 或 zipfian
+    double zipf_theta = 0.99;
+};
+
+static void printUsage(const char* program) {
+    std::cerr << "用法: " << program << " [--target=host:port] [--channels=N] [--concurrency=M]\n"
+              << "       [--rate=QPS] [--duration=秒] [--warmup=秒] [--mix=插入:更新:删除]\n"
+              << "       [--keys=N] [--dist=uniform|zipfian] [--zipf_theta=0.99]\n"
+              << "结果以单行 JSON 输出到 stdout，进度与摘要输出到 stderr" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, LoadgenOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        try {
+            if (key == "target") {
+                options.target = value;
+            } else if (key == "channels") {
+                options.channels = std::max(1, std::stoi(value));
+            } else if (key == "concurrency") {
+                options.concurrency = std::max(1, std::stoi(value));
+            } else if (key == "rate") {
+                options.rate = std::max(0.0, std::stod(value));
+            } else if (key == "duration") {
+                options.duration_sec = std::max(0.1, std::stod(value));
+            } else if (key == "warmup") {
+                options.warmup_sec = std::max(0.0, std::stod(value));
+            } else if (key == "mix") {
+                if (std::sscanf(value.c_str(), "%d:%d:%d", &options.insert_weight,
+                                &options.update_weight, &options.delete_weight) != 3 ||
+                    options.insert_weight < 0 || options.update_weight < 0 || options.delete_weight < 0 ||
+                    options.insert_weight + options.update_weight + options.delete_weight == 0) {
+                    return false;
+                }
+            } else if (key == "keys") {
+                options.keys = std::max<uint64_t>(1, std::stoull(value));
+            } else if (key == "dist") {
+                if (value != "uniform" && value != "zipfian") {
+                    return false;
+                }
+                options.dist = value;
+            } else if (key == "zipf_theta") {
+                options.zipf_theta = std::stod(value);
+                if (options.zipf_theta <= 0 || options.zipf_theta == 1.0) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Zipfian 分布（Gray 等人的算法，与 YCSB 相同），0 号 key 最热；zeta 在构造时一次算好
+class zipfianGenerator {
+public:
+    zipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+        for (uint64_t i = 1; i <= n_; ++i) {
+            zeta_n_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+        }
+        double zeta_2 = 1.0 + 1.0 / std::pow(2.0, theta_);
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n_), 1.0 - theta_)) / (1.0 - zeta_2 / zeta_n_);
+    }
+
+    uint64_t next(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zeta_n_;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta_)) {
+            return n_ > 1 ? 1 : 0;
+        }
+        auto key = static_cast<uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return key < n_ ? key : n_ - 1;
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zeta_n_ = 0;
+    double alpha_ = 0;
+    double eta_ = 0;
+};
+
+class loadGenerator {
+public:
+    explicit loadGenerator(const LoadgenOptions& options) : options_(options) {
+        if (options_.dist == "zipfian") {
+            zipf_ = std::make_unique<zipfianGenerator>(options_.keys, options_.zipf_theta);
+        }
+        // 测量服务端本身：不设截止时间，不发对冲请求
+        ClientOptions client_options;
+        client_options.target = options_.target;
+        client_options.channels = options_.channels;
+        client_options.cq_threads = std::max(1, std::min(options_.channels, 
+            static_cast<int>(std::thread::hardware_concurrency())));
+        client_options.deadline_ms = 0;
+        client_options.hedge_reads = false;
+        client_ = std::make_unique<DBClient>(client_options);
+    }
+
+    void run() {
+        start_ = Clock::now();
+        measure_start_ = start_ + toDuration(options_.warmup_sec);
+        end_ = measure_start_ + toDuration(options_.duration_sec);
+
+        if (options_.rate > 0) {
+            runOpenLoop();
+        } else {
+            in_flight_ = options_.channels * options_.concurrency;
+            for (int slot = 0; slot < options_.channels * options_.concurrency; ++slot) {
+                issue(Clock::now());
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(done_mutex_);
+        done_cond_.wait(lock, [this]() { return in_flight_ == 0; });
+    }
+
+    void report() const {
+        latencyHistogram::Snapshot snapshot = latency_.snapshot();
+        uint64_t errors = 0;
+        std::string statuses;
+        for (int code = 0; code < dbMetrics::STATUS_CODES; ++code) {
+            uint64_t count = status_counts_[code].load();
+            if (code != 0) {
+                errors += count;
+            }
+            if (count > 0) {
+                statuses += std::string(statuses.empty() ? "" : ",") + "\"" +
+                            dbMetrics::statusName(code) + "\":" + std::to_string(count);
+            }
+        }
+        double qps = static_cast<double>(snapshot.count) / options_.duration_sec;
+        double mean = snapshot.count > 0 ? static_cast<double>(snapshot.sum) / static_cast<double>(snapshot.count) : 0;
+
+        char line[1024];
+        std::snprintf(line, sizeof(line),
+            "{\"mode\":\"%s\",\"target\":\"%s\",\"channels\":%d,\"concurrency\":%d,\"rate\":%.1f,"
+            "\"duration_sec\":%.1f,\"mix\":\"%d:%d:%d\",\"dist\":\"%s\",\"keys\":%llu,"
+            "\"requests\":%llu,\"errors\":%llu,\"skipped\":%llu,\"qps\":%.1f,\"mean_us\":%.1f,"
+            "\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,\"p999_us\":%llu,\"max_us\":%llu,",
+            options_.rate > 0 ? "open" : "closed", options_.target.c_str(), options_.channels,
+            options_.concurrency, options_.rate, options_.duration_sec, options_.insert_weight,
+            options_.update_weight, options_.delete_weight, options_.dist.c_str(),
+            static_cast<unsigned long long>(options_.keys),
+            static_cast<unsigned long long>(snapshot.count), static_cast<unsigned long long>(errors),
+            static_cast<unsigned long long>(skipped_.load()), qps, mean,
+            static_cast<unsigned long long>(snapshot.percentile(0.5)),
+            static_cast<unsigned long long>(snapshot.percentile(0.9)),
+            static_cast<unsigned long long>(snapshot.percentile(0.99)),
+            static_cast<unsigned long long>(snapshot.percentile(0.999)),
+            static_cast<unsigned long long>(snapshot.max));
+        std::cout << line << "\"status\":{" << statuses << "}}" << std::endl;
+
+        std::cerr << "完成: " << snapshot.count << " 个请求, 错误 " << errors
+                  << ", QPS " << static_cast<long long>(qps)
+                  << ", p50/p99/p99.9 = " << snapshot.percentile(0.5) << "/"
+                  << snapshot.percentile(0.99) << "/" << snapshot.percentile(0.999) << " us" << std::endl;
+    }
+
+private:
+
+    static Clock::duration toDuration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void fillRequest(DBRequest& request) {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        int total = options_.insert_weight + options_.update_weight + options_.delete_weight;
+        int pick = std::uniform_int_distribution<int>(0, total - 1)(rng);
+        if (pick < options_.insert_weight) {
+            request.set_operation(DBRequest::INSERT);
+        } else if (pick < options_.insert_weight + options_.update_weight) {
+            request.set_operation(DBRequest::UPDATE);
+        } else {
+            request.set_operation(DBRequest::DELETE);
+        }
+
+        uint64_t key = zipf_ ? zipf_->next(rng)
+                             : std::uniform_int_distribution<uint64_t>(0, options_.keys - 1)(rng);
+        request.mutable_user_info()->set_name("user_" + std::to_string(key));
+        request.mutable_user_info()->set_age(std::uniform_int_distribution<int>(1, 100)(rng));
+    }
+
+    // 发起一个 RPC，scheduled 在开环模式下为计划发送时间，避免协调遗漏；
+    // 闭环模式下完成回调中立即发起下一个，连接由客户端轮询选择
+    void issue(Clock::time_point scheduled) {
+        DBRequest request;
+        fillRequest(request);
+        client_->ExecuteOperation(request, [this, scheduled](const Status& status, DBResponse&&) {
+            auto now = Clock::now();
+            if (scheduled >= measure_start_ && now <= end_) {
+                latency_.record(now - scheduled);
+                int code = static_cast<int>(status.error_code());
+                status_counts_[code >= 0 && code < dbMetrics::STATUS_CODES ? code : 2]++;
+            }
+            if (options_.rate <= 0 && now < end_) {
+                issue(Clock::now());
+            } else {
+                finishOne();
+            }
+        });
+    }
+
+    void finishOne() {
+        std::unique_lock<std::mutex> lock(done_mutex_);
+        if (--in_flight_ == 0) {
+            done_cond_.notify_all();
+        }
+    }
+
+    // 开环：按固定速率发送，与服务端响应快慢无关；
+    // 在途请求达到 channels * concurrency 时跳过该次发送并计入 skipped
+    void runOpenLoop() {
+        auto interval = toDuration(1.0 / options_.rate);
+        int max_in_flight = options_.channels * options_.concurrency;
+        for (auto next = start_; next < end_; next += interval) {
+            std::this_thread::sleep_until(next);
+            {
+                std::unique_lock<std::mutex> lock(done_mutex_);
+                if (in_flight_ >= max_in_flight) {
+                    if (next >= measure_start_) {
+                        ++skipped_;
+                    }
+                    continue;
+                }
+                ++in_flight_;
+            }
+            issue(next);
+        }
+    }
+
+    LoadgenOptions options_;
+    std::unique_ptr<zipfianGenerator> zipf_;
+    std::unique_ptr<DBClient> client_;
+    Clock::time_point start_;
+    Clock::time_point measure_start_;
+    Clock::time_point end_;
+
+    latencyHistogram latency_;
+    std::atomic<uint64_t> status_counts_[dbMetrics::STATUS_CODES] = {};
+    std::atomic<uint64_t> skipped_{0};
+
+    std::mutex done_mutex_;
+    std::condition_variable done_cond_;
+    int in_flight_ = 0;
+};
+
+int main(int argc, char** argv) {
+    LoadgenOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::cerr << "压测 " << options.target << ": " << options.channels << " 个连接 x "
+              << options.concurrency << " 并发, "
+              << (options.rate > 0 ? "开环 " + std::to_string(static_cast<long long>(options.rate)) + " QPS"
+                                   : std::string("闭环"))
+              << ", 预热 " << options.warmup_sec << "s, 测量 " << options.duration_sec << "s" << std::endl;
+
+    loadGenerator generator(options);
+    generator.run();
+    generator.report();
+    return 0;
+}
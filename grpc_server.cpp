@@ -1,161 +1,89 @@
-#include "mysqlDao.h"
-#include "mysqlMgr.h"
+#include "dbService.h"
 #include "configMgr.h"
+#include "asyncLogger.h"
+#include "metricsServer.h"
+#include "slowLog.h"
 #include <grpcpp/grpcpp.h>
-#include "mgrMysql.grpc.pb.h"
-#include "mgrMysql.pb.h"
-#include <iomanip>
-#include <ctime>
+#include <grpcpp/health_check_service_interface.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
 
 using grpc::Server;
 using grpc::ServerBuilder;
-using grpc::ServerContext;
-using grpc::Status;
-using namespace db_operations;
 
-// 获取当前时间的字符串
-std::string getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    auto now_tm = std::localtime(&now_c);
-    
-    char buffer[80];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", now_tm);
-    return std::string(buffer);
-}
+int main(int /*argc*/, char** /*argv*/) {
+    try {
+        configMgr& config = configMgr::getInstance();
+        std::shared_ptr<const ServerConfig> startup = config.current();
+        std::string server_address = startup->grpc.host + ":" + std::to_string(startup->grpc.port);
+        const std::string& mode = startup->grpc.mode;
 
-// 打印操作日志
-void logOperation(const std::string& operation, const UserInfo& user_info, 
-                 bool success, const std::string& message) {
-    std::cout << "=====================================" << std::endl;
-    std::cout << "时间: " << getCurrentTime() << std::endl;
-    std::cout << "操作: " << operation << std::endl;
-    std::cout << "用户信息:" << std::endl;
-    std::cout << "  姓名: " << user_info.name() << std::endl;
-    std::cout << "  年龄: " << user_info.age() << std::endl;
-    std::cout << "状态: " << (success ? "成功" : "失败") << std::endl;
-    std::cout << "消息: " << message << std::endl;
-    std::cout << "=====================================" << std::endl;
-}
+        asyncLogger::getInstance().configure(startup->log);
+        slowLog::getInstance().configure(startup->trace);
 
-class DBServiceImpl final : public DBService::Service {
-public:
-    DBServiceImpl() {
-        try {
-            mysqlMgr_ = std::make_unique<mysqlMgr>();
-            std::cout << "数据库管理器初始化成功" << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "数据库管理器初始化失败: " << e.what() << std::endl;
-            throw;
+        std::unique_ptr<DBServiceImpl> service;
+        if (mode == "sync") {
+            service = std::make_unique<DBServiceImpl>(*startup);
+        } else {
+            service = std::make_unique<DBAsyncServiceImpl>(*startup);
         }
-    }
 
-private:
-    Status HandleInsert(const UserInfo& user_info, DBResponse* response) {
-        try {
-            if (mysqlMgr_->insert(user_info.name(), user_info.age())) {
-                response->set_success(true);
-                response->set_message("插入成功");
-                logOperation("INSERT", user_info, true, "插入成功");
-                return Status::OK;
-            } else {
-                response->set_success(false);
-                response->set_message("插入失败");
-                logOperation("INSERT", user_info, false, "插入失败");
-                return Status(grpc::StatusCode::INTERNAL, "Database insert operation failed");
-            }
-        } catch (const std::exception& e) {
-            response->set_success(false);
-            response->set_message(std::string("插入异常: ") + e.what());
-            logOperation("INSERT", user_info, false, e.what());
-            return Status(grpc::StatusCode::INTERNAL, e.what());
-        }
-    }
+        // 标准健康检查服务（grpc.health.v1.Health）：连接池预热完成前报告 NOT_SERVING
+        grpc::EnableDefaultHealthCheckService(true);
 
-    Status HandleUpdate(const UserInfo& user_info, DBResponse* response) {
-        try {
-            if (mysqlMgr_->update(user_info.name(), user_info.age())) {
-                response->set_success(true);
-                response->set_message("更新成功");
-                logOperation("UPDATE", user_info, true, "更新成功");
-                return Status::OK;
-            } else {
-                response->set_success(false);
-                response->set_message("更新失败");
-                logOperation("UPDATE", user_info, false, "更新失败");
-                return Status(grpc::StatusCode::INTERNAL, "Database update operation failed");
-            }
-        } catch (const std::exception& e) {
-            response->set_success(false);
-            response->set_message(std::string("更新异常: ") + e.what());
-            logOperation("UPDATE", user_info, false, e.what());
-            return Status(grpc::StatusCode::INTERNAL, e.what());
-        }
-    }
-
-    Status HandleDelete(const UserInfo& user_info, DBResponse* response) {
-        try {
-            if (mysqlMgr_->deleteData(user_info.name(), user_info.age())) {
-                response->set_success(true);
-                response->set_message("删除成功");
-                logOperation("DELETE", user_info, true, "删除成功");
-                return Status::OK;
-            } else {
-                response->set_success(false);
-                response->set_message("删除失败");
-                logOperation("DELETE", user_info, false, "删除失败");
-                return Status(grpc::StatusCode::INTERNAL, "Database delete operation failed");
-            }
-        } catch (const std::exception& e) {
-            response->set_success(false);
-            response->set_message(std::string("删除异常: ") + e.what());
-            logOperation("DELETE", user_info, false, e.what());
-            return Status(grpc::StatusCode::INTERNAL, e.what());
-        }
-    }
+        ServerBuilder builder;
+        builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+        builder.RegisterService(service.get());
 
-public:
-    Status ExecuteOperation(ServerContext* /*context*/, const DBRequest* request,
-                          DBResponse* response) override {
-        try {
-            const UserInfo& user_info = request->user_info();
-            
-            switch(request->operation()) {
-                case DBRequest::INSERT:
-                    return HandleInsert(user_info, response);
-                case DBRequest::UPDATE:
-                    return HandleUpdate(user_info, response);
-                case DBRequest::DELETE:
-                    return HandleDelete(user_info, response);
-                default:
-                    response->set_success(false);
-                    response->set_message("未知操作类型");
-                    return Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown operation type");
-            }
-        } catch (const std::exception& e) {
-            response->set_success(false);
-            response->set_message(std::string("操作异常: ") + e.what());
-            return Status(grpc::StatusCode::INTERNAL, e.what());
+        std::unique_ptr<Server> server(builder.BuildAndStart());
+        if (!server) {
+            throw std::runtime_error("无法监听 " + server_address);
         }
-    }
+        std::cout << "服务器正在监听: " << server_address 
+                  << " (" << (mode == "sync" ? "同步" : "异步") << "模式)" << std::endl;
 
-private:
-    std::unique_ptr<mysqlMgr> mysqlMgr_;
-};
+        grpc::HealthCheckServiceInterface* health = server->GetHealthCheckService();
+        health->SetServingStatus(false);
+        health->SetServingStatus(DBService::service_full_name(), false);
 
-int main(int /*argc*/, char** /*argv*/) {
-    try {
-        std::string server_address = "0.0.0.0:50051";
-        DBServiceImpl service;
+        std::unique_ptr<metricsServer> metrics_endpoint;
+        int prometheus_port = startup->metrics.prometheus_port;
+        if (prometheus_port > 0) {
+            const std::string& prometheus_host = startup->metrics.prometheus_host;
+            DBServiceImpl* impl = service.get();
+            metrics_endpoint = std::make_unique<metricsServer>(prometheus_host, prometheus_port, 
+                [impl]() { return impl->RenderPrometheus(); });
+            std::cout << "Prometheus 指标端点: http://" << prometheus_host << ":" 
+                      << prometheus_port << "/metrics" << std::endl;
+        }
 
-        ServerBuilder builder;
-        builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
-        builder.RegisterService(&service);
+        // 配置文件修改后自动重新加载并应用到服务与日志；
+        // subscription 先于 service 销毁，之后的重新加载不会再访问已释放的服务
+        DBServiceImpl* reload_impl = service.get();
+        configMgr::Subscription subscription = config.subscribe([reload_impl](const ServerConfig& previous, const ServerConfig& next) {
+            asyncLogger::getInstance().configure(next.log);
+            slowLog::getInstance().configure(next.trace);
+            reload_impl->ApplyConfig(previous, next);
+        });
+        config.watch();
 
-        std::unique_ptr<Server> server(builder.BuildAndStart());
-        std::cout << "服务器正在监听: " << server_address << std::endl;
+        // 就绪线程在所有可能抛出异常的初始化之后启动，异常不会越过尚未 join 的线程
+        std::atomic<bool> stopping{false};
+        DBServiceImpl* warm_impl = service.get();
+        std::thread readiness([&stopping, warm_impl, health]() {
+            while (!stopping && !warm_impl->WaitWarmUp(std::chrono::milliseconds(500))) {
+            }
+            if (!stopping) {
+                health->SetServingStatus(true);
+                health->SetServingStatus(DBService::service_full_name(), true);
+                std::cout << "服务就绪, 健康检查状态: SERVING" << std::endl;
+            }
+        });
 
         server->Wait();
+        stopping = true;
+        readiness.join();
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "服务器启动失败: " << e.what() << std::endl;
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 最小的 HTTP 端点，供 Prometheus 抓取：任何 GET 请求都返回 render() 的文本。
+// 抓取频率很低，单线程逐个处理连接即可，不引入额外的 HTTP 依赖
+class metricsServer {
+public:
+    metricsServer(const std::string& host, int port, std::function<std::string()> render)
+        : render_(std::move(render)) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error(std::string("指标端点 socket 创建失败: ") + std::strerror(errno));
+        }
+        int reuse = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            ::close(listen_fd_);
+            throw std::runtime_error("指标端点地址无效: " + host);
+        }
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd_, 16) < 0) {
+            std::string error = std::strerror(errno);
+            ::close(listen_fd_);
+            throw std::runtime_error("指标端点监听失败: " + error);
+        }
+        thread_ = std::thread([this]() { serveLoop(); });
+    }
+
+    ~metricsServer() {
+        stop_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        ::close(listen_fd_);
+    }
+
+    metricsServer(const metricsServer&) = delete;
+    metricsServer& operator=(const metricsServer&) = delete;
+
+private:
+    static const int POLL_INTERVAL_MS = 200;
+    static const int IO_TIMEOUT_MS = 1000;
+
+    void serveLoop() {
+        while (!stop_) {
+            pollfd pfd{listen_fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+                continue;
+            }
+            int client = ::accept(listen_fd_, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            handle(client);
+            ::close(client);
+        }
+    }
+
+    void handle(int client) {
+        // 只需读到请求行，请求体与其余头部直接忽略
+        char request[1024];
+        std::size_t received = 0;
+        while (received < sizeof(request) - 1) {
+            pollfd pfd{client, POLLIN, 0};
+            if (::poll(&pfd, 1, IO_TIMEOUT_MS) <= 0) {
+                return;
+            }
+            ssize_t n = ::recv(client, request + received, sizeof(request) - 1 - received, 0);
+            if (n <= 0) {
+                return;
+            }
+            received += static_cast<std::size_t>(n);
+            request[received] = '\0';
+            if (std::strstr(request, "\r\n") != nullptr) {
+                break;
+            }
+        }
+
+        std::string body;
+        const char* status = "200 OK";
+        if (std::strncmp(request, "GET ", 4) != 0) {
+            status = "405 Method Not Allowed";
+        } else {
+            try {
+                body = render_();
+            } catch (const std::exception& e) {
+                status = "500 Internal Server Error";
+                body = e.what();
+            }
+        }
+
+        std::string response = std::string("HTTP/1.1 ") + status + "\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+        std::size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+
+    std::function<std::string()> render_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
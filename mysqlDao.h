@@ -7,69 +7,301 @@
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <mutex>
-#include <queue>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <condition_variable>
 #include <chrono>
 #include <functional>
+#include "circuitBreaker.h"
+#include "dbMetrics.h"
+#include "requestScope.h"
+
+// 以 string_view 绑定字符串参数。Connector/C++ 只接受 SQLString，
+// 这里经线程内复用的缓冲转换，稳定状态下绑定参数不再分配内存
+inline void bindString(sql::PreparedStatement* pstmt, unsigned int index, std::string_view value) {
+    thread_local std::string buffer;
+    thread_local sql::SQLString param;
+    buffer.assign(value.data(), value.size());
+    param = buffer;
+    pstmt->setString(index, param);
+}
+
+// 与 MySQL 的一次往返：计入全局指标与当前请求（若有）。
+// 语句执行、服务端 prepare、事务控制与 ping 都应经此计数，测试据此断言每个请求的往返次数
+inline void countRoundTrip() {
+    dbMetrics::getInstance().round_trips.fetch_add(1, std::memory_order_relaxed);
+    requestScope::noteRoundTrip();
+}
+
+inline int executeUpdate(sql::PreparedStatement* pstmt) {
+    countRoundTrip();
+    phaseTimer timer(TracePhase::Execute);
+    return pstmt->executeUpdate();
+}
+
+// 返回的结果集归调用方所有
+inline sql::ResultSet* executeQuery(sql::PreparedStatement* pstmt) {
+    countRoundTrip();
+    phaseTimer timer(TracePhase::Execute);
+    return pstmt->executeQuery();
+}
 
 class SqlConnection {
 public:
-    SqlConnection(sql::Connection* conn, long long time) 
-        : conn_(conn), time_(time) {}
+    SqlConnection(sql::Connection* conn, long long time, std::size_t stmt_cache_size = 16) 
+        : conn_(conn), time_(time), last_used_(time), stmt_cache_size_(stmt_cache_size) {}
     
     ~SqlConnection() {
+        reset(nullptr);
+    }
+
+    // 取出 sql 对应的预处理语句，命中缓存时省去服务端 prepare 和释放的往返；
+    // 命中时按 string_view 查找，不构造 std::string。返回的语句归本连接所有，调用方不得 delete
+    sql::PreparedStatement* prepare(std::string_view sql) {
+        requestScope::noteSql(sql);
+        auto it = stmt_index_.find(sql);
+        if (it != stmt_index_.end()) {
+            stmt_lru_.splice(stmt_lru_.begin(), stmt_lru_, it->second);
+            dbMetrics::getInstance().stmt_cache_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second.get();
+        }
+
+        dbMetrics& metrics = dbMetrics::getInstance();
+        metrics.stmt_cache_misses.fetch_add(1, std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        std::string text(sql);
+        countRoundTrip();
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn_->prepareStatement(text));
+        auto end = std::chrono::steady_clock::now();
+        metrics.prepare_latency.record(end - start);
+        requestScope::notePhase(TracePhase::Prepare, start, end);
+        if (stmt_cache_size_ == 0) {
+            // 未开启缓存时仍由连接持有，下一次 prepare 时释放
+            stmt_index_.clear();
+            stmt_lru_.clear();
+        } else if (stmt_lru_.size() >= stmt_cache_size_) {
+            stmt_index_.erase(stmt_lru_.back().first);
+            stmt_lru_.pop_back();
+        }
+        stmt_lru_.emplace_front(std::move(text), std::move(pstmt));
+        // 索引的键指向链表节点中的 sql 文本，节点在淘汰前地址不变
+        stmt_index_[stmt_lru_.front().first] = stmt_lru_.begin();
+        return stmt_lru_.front().second.get();
+    }
+
+    // 开始显式事务。连接始终处于自动提交模式，START TRANSACTION 一次往返即可，
+    // 结束后也无需恢复 autocommit
+    void begin() {
+        if (!control_) {
+            control_.reset(conn_->createStatement());
+        }
+        countRoundTrip();
+        phaseTimer timer(TracePhase::Execute);
+        control_->execute("START TRANSACTION");
+    }
+
+    void commit() {
+        countRoundTrip();
+        phaseTimer timer(TracePhase::Commit);
+        conn_->commit();
+    }
+
+    void rollback() {
+        countRoundTrip();
+        phaseTimer timer(TracePhase::Commit);
+        conn_->rollback();
+    }
+
+    // 替换底层连接（重连时使用），旧连接上的预处理语句全部失效
+    void reset(sql::Connection* conn) {
+        stmt_index_.clear();
+        stmt_lru_.clear();  // 语句必须先于所属连接释放
+        control_.reset();
         if (conn_) {
-            conn_->close();
+            try {
+                conn_->close();
+            } catch (...) {} // 已断开的连接关闭时可能抛异常
             delete conn_;
         }
+        conn_ = conn;
     }
     
     sql::Connection* conn_;
-    long long time_;
+    long long time_;       // 最近一次确认连接可用的时间
+    long long last_used_;  // 最近一次归还连接池的时间，用于空闲收缩
+    long long statement_timeout_ms_ = 0;  // 会话上已下发的语句超时，0 表示服务端默认值
+
+private:
+    using StmtEntry = std::pair<std::string, std::unique_ptr<sql::PreparedStatement>>;
+
+    std::size_t stmt_cache_size_;
+    std::list<StmtEntry> stmt_lru_;  // 表头为最近使用
+    std::unordered_map<std::string_view, std::list<StmtEntry>::iterator> stmt_index_;
+    std::unique_ptr<sql::Statement> control_;  // 事务控制语句，首次开始事务时创建
+};
+
+// 固定容量的空闲连接环：back 为热端（最近归还），front 为冷端（最久未用）；
+// 槽位在构造时一次分配，借出与归还只移动指针
+class connectionRing {
+public:
+    explicit connectionRing(std::size_t capacity) : slots_(std::max<std::size_t>(1, capacity)) {}
+
+    std::size_t size() const {
+        return count_;
+    }
+
+    bool empty() const {
+        return count_ == 0;
+    }
+
+    void pushBack(std::unique_ptr<SqlConnection> conn) {
+        slots_[(head_ + count_) % slots_.size()] = std::move(conn);
+        ++count_;
+    }
+
+    void pushFront(std::unique_ptr<SqlConnection> conn) {
+        head_ = (head_ + slots_.size() - 1) % slots_.size();
+        slots_[head_] = std::move(conn);
+        ++count_;
+    }
+
+    std::unique_ptr<SqlConnection> popBack() {
+        --count_;
+        return std::move(slots_[(head_ + count_) % slots_.size()]);
+    }
+
+    std::unique_ptr<SqlConnection> popFront() {
+        auto conn = std::move(slots_[head_]);
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        return conn;
+    }
+
+    // 第 i 个（从冷端数起）连接
+    SqlConnection& at(std::size_t i) {
+        return *slots_[(head_ + i) % slots_.size()];
+    }
+
+    // 取出第 i 个连接，空位由冷端的连接填补
+    std::unique_ptr<SqlConnection> take(std::size_t i) {
+        std::size_t index = (head_ + i) % slots_.size();
+        auto conn = std::move(slots_[index]);
+        if (index != head_) {
+            slots_[index] = std::move(slots_[head_]);
+        }
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        return conn;
+    }
+
+    void clear() {
+        while (!empty()) {
+            popFront();
+        }
+    }
+
+    // 扩大容量（连接池上限调大时），已有连接保持原顺序
+    void reserve(std::size_t capacity) {
+        if (capacity <= slots_.size()) {
+            return;
+        }
+        std::vector<std::unique_ptr<SqlConnection>> slots(capacity);
+        for (std::size_t i = 0; i < count_; ++i) {
+            slots[i] = std::move(slots_[(head_ + i) % slots_.size()]);
+        }
+        slots_.swap(slots);
+        head_ = 0;
+    }
+
+private:
+    std::vector<std::unique_ptr<SqlConnection>> slots_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+};
+
+// 连接池参数，对应 config.ini 的 [mysql] 部分
+struct PoolOptions {
+    int min_conn_num = 2;          // pool_min_size: 常驻连接数
+    int max_conn_num = 8;          // pool_max_size: 按需扩容的上限
+    int acquire_timeout_ms = 1000; // acquire_timeout_ms: 等待空闲连接的最长时间
+    int idle_timeout_sec = 300;    // idle_timeout_sec: 超过该空闲时间的连接会被回收到 min
+    int stmt_cache_size = 16;      // stmt_cache_size: 每个连接缓存的预处理语句数，0 表示不缓存
+    int keepalive_interval_sec = 60; // keepalive_interval_sec: 后台保活检查周期
+    int validate_idle_sec = 30;    // validate_idle_sec: 空闲超过该时间的连接借出前先 ping，负数关闭
+    int shards = 0;                // pool_shards: 空闲连接分片数，0 表示 min(CPU 核数, max_conn_num)
+    int warmup_threads = 4;        // pool_warmup_threads: 启动时并行建立连接的线程数
+    int ready_min = -1;            // pool_ready_min: 构造返回前至少建好的连接数，其余在后台继续预热；
+                                   // 负数表示等待 min_conn_num 个全部建好，0 表示不等待
 };
 
 class mysqlDao {
 public:
+    // 建立一条已选好数据库的底层连接，失败时抛出 sql::SQLException；
+    // 默认经 MySQL 驱动建连，基准测试可注入不依赖真实数据库的替身
+    using ConnectionFactory = std::function<sql::Connection*()>;
+
     mysqlDao(const std::string &host, const std::string &user, 
              const std::string &password, const std::string &database, 
-             const std::string &port)
-        : host_(host), user_(user), password_(password), 
-          database_(database), port_(port), 
+             const std::string &port, const PoolOptions &options = PoolOptions(),
+             const BreakerOptions &breaker = BreakerOptions())
+        : mysqlDao(driverFactory(host, user, password, database, port), 
+                   "tcp://" + host + ":" + port, options, breaker) {}
+
+    mysqlDao(ConnectionFactory factory, const std::string &endpoint, 
+             const PoolOptions &options = PoolOptions(),
+             const BreakerOptions &breaker = BreakerOptions())
+        : min_conn_num_(std::max(1, options.min_conn_num)),
+          max_conn_num_(std::max(std::max(1, options.min_conn_num), options.max_conn_num)),
+          acquire_timeout_ms_(std::max(0, options.acquire_timeout_ms)),
+          idle_timeout_sec_(options.idle_timeout_sec),
+          stmt_cache_size_(static_cast<std::size_t>(std::max(0, options.stmt_cache_size))),
+          keepalive_interval_sec_(std::max(1, options.keepalive_interval_sec)),
+          validate_idle_sec_(options.validate_idle_sec),
+          factory_(std::move(factory)), 
+          endpoint_(endpoint),
           nums_(0), stop_(false),  // 修复初始化顺序
-          driver_(get_driver_instance())
+          breaker_(breaker)
     {
+        int shard_num = options.shards > 0 
+            ? options.shards 
+            : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        shard_num = std::max(1, std::min(shard_num, max_conn_num_.load()));
+        for (int i = 0; i < shard_num; ++i) {
+            shards_.push_back(std::make_unique<Shard>(static_cast<std::size_t>(max_conn_num_.load())));
+        }
+
         try {
-            std::string connection_url = "tcp://" + host_ + ":" + port_;
-            std::cout << "正在连接数据库: " << connection_url << std::endl;
-            
-            for (int i = 0; i < max_conn_num_; ++i) {
-                try {
-                    sql::Connection* conn = driver_->connect(connection_url, user_, password_);
-                    conn->setSchema(database_);
-                    conn_queue_.push(std::make_unique<SqlConnection>(conn, getCurrentTime()));
-                    std::cout << "成功创建连接 #" << (i + 1) << std::endl;
-                } catch (const sql::SQLException &e) {
-                    std::cerr << "连接 #" << (i + 1) << " 创建失败: " << e.what() << std::endl;
-                    std::cerr << "错误代码: " << e.getErrorCode() << std::endl;
-                    std::cerr << "SQL状态: " << e.getSQLState() << std::endl;
-                }
+            std::cout << "正在连接数据库: " << endpoint 
+                      << " (连接池 " << min_conn_num_ << "-" << max_conn_num_ << ")" << std::endl;
+
+            // 常驻连接由多个线程并行建立，达到 ready_min 个即返回，剩余的在后台继续
+            int min_conn_num = min_conn_num_.load();
+            int ready_min = options.ready_min < 0 ? min_conn_num : std::min(options.ready_min, min_conn_num);
+            int warmup_threads = std::max(1, std::min(options.warmup_threads, min_conn_num));
+            warm_workers_ = warmup_threads;
+            for (int i = 0; i < warmup_threads; ++i) {
+                warmup_threads_.emplace_back([this]() { warmUp(); });
             }
-            
-            if (conn_queue_.empty()) {
+
+            bool failed = false;
+            {
+                std::unique_lock<std::mutex> lock(warm_mutex_);
+                warm_cond_.wait(lock, [&]() { return warm_created_ >= ready_min || warm_workers_ == 0; });
+                failed = ready_min > 0 && warm_created_ == 0;
+            }
+            if (failed) {
+                joinWarmUp();
                 throw std::runtime_error("无法创建任何数据库连接");
             }
 
-            keep_alive_thread_ = std::thread([this]() {
-                while (!stop_) {
-                    std::this_thread::sleep_for(std::chrono::seconds(60));
-                    keepAlive();
-                }
-            });
-            keep_alive_thread_.detach();
+            keep_alive_thread_ = std::thread([this]() { maintenanceLoop(); });
         } catch (const std::exception &e) {
             std::cerr << "数据库初始化错误: " << e.what() << std::endl;
             throw;
@@ -77,63 +309,393 @@ public:
     }
 
     ~mysqlDao() {
-        stop_ = true;
+        {
+            std::unique_lock<std::mutex> lock(maint_mutex_);
+            stop_ = true;
+        }
+        maint_cond_.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(warm_mutex_);
+            warm_cond_.notify_all();
+        }
         if (keep_alive_thread_.joinable()) {
             keep_alive_thread_.join();
         }
-        std::unique_lock<std::mutex> lock(conn_mutex_);
-        while (!conn_queue_.empty()) {
-            conn_queue_.pop();
+        joinWarmUp();
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->ring.clear();
         }
+        std::unique_lock<std::mutex> lock(conn_mutex_);
+        conn_cond_.notify_all();
     }
 
+    // 在请求作用域内不会等待超过请求的剩余时间，请求已取消或已超时时直接返回空；
+    // 熔断器断开时直接返回空并把请求标记为不可用，不等待连接池也不尝试建连
     std::unique_ptr<SqlConnection> getConnection() {
-        std::unique_lock<std::mutex> lock(conn_mutex_);
-        if (!conn_queue_.empty()) {
-            auto conn = std::move(conn_queue_.front());
-            conn_queue_.pop();
-            return conn;
+        std::chrono::milliseconds timeout(acquire_timeout_ms_.load(std::memory_order_relaxed));
+        const requestScope* scope = requestScope::current();
+        if (scope) {
+            if (scope->aborted()) {
+                return nullptr;
+            }
+            if (scope->hasDeadline()) {
+                timeout = std::min(timeout, scope->remaining());
+            }
         }
-        return nullptr;
+        if (!breaker_.allow()) {
+            requestScope::noteUnavailable();
+            return nullptr;
+        }
+        return getConnection(timeout);
     }
 
-    void releaseConnection(std::unique_ptr<SqlConnection> conn) {
-        std::unique_lock<std::mutex> lock(conn_mutex_);
+    // 熔断器未断开（闭合或半开），可以接收请求
+    bool available() const {
+        return !breaker_.isOpen();
+    }
+
+    const circuitBreaker& breaker() const {
+        return breaker_;
+    }
+
+    // 获取连接：优先从本线程的分片取空闲连接，再从其他分片窃取，
+    // 未达上限时扩容，否则在 conn_cond_ 上等待直到超时
+    std::unique_ptr<SqlConnection> getConnection(std::chrono::milliseconds timeout) {
+        auto start = std::chrono::steady_clock::now();
+        auto conn = acquireConnection(start + timeout, timeout);
+        auto end = std::chrono::steady_clock::now();
+        requestScope::notePhase(TracePhase::Acquire, start, end);
+        dbMetrics& metrics = dbMetrics::getInstance();
         if (conn) {
-            conn_queue_.push(std::move(conn));
+            metrics.pool_acquire.record(end - start);
+        } else {
+            metrics.pool_acquire_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+        return conn;
+    }
+
+    // 连接池当前状态，仅用于指标采集
+    struct PoolStats {
+        int total;
+        int idle;
+        int max;
+    };
+
+    PoolStats stats() {
+        return PoolStats{nums_.load(), idle_num_.load(), max_conn_num_.load()};
+    }
+
+    // 启动预热已结束（min_conn_num 个常驻连接都已尝试建立）且至少有一个连接可用
+    bool warmedUp() {
+        std::unique_lock<std::mutex> lock(warm_mutex_);
+        return warm_workers_ == 0 && nums_ > 0;
+    }
+
+    // 等待预热结束且至少有一个连接可用，超时返回 false。预热结束后仍没有连接时继续等待，
+    // 直到后台补充或按需扩容建立了新连接
+    bool waitWarmUp(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(warm_mutex_);
+        warm_cond_.wait_for(lock, timeout, [this]() { return (warm_workers_ == 0 && nums_ > 0) || stop_; });
+        return warm_workers_ == 0 && nums_ > 0;
+    }
+
+    // 借出的连接已损坏、不再归还时调用，让出一个扩容名额并通知后台补充
+    void discardConnection() {
+        dbMetrics::getInstance().pool_discarded.fetch_add(1, std::memory_order_relaxed);
+        releaseSlot();
+        std::unique_lock<std::mutex> lock(maint_mutex_);
+        refill_needed_ = true;
+        maint_cond_.notify_one();
+    }
+
+private:
+    std::unique_ptr<SqlConnection> acquireConnection(std::chrono::steady_clock::time_point deadline,
+                                                     std::chrono::milliseconds timeout) {
+        std::size_t home = homeShard();
+        bool grow = true;  // 本次扩容建连失败后不再尝试扩容，只等待其他请求归还连接
+        while (!stop_) {
+            if (auto conn = takeIdle(home)) {
+                int validate_idle_sec = validate_idle_sec_.load(std::memory_order_relaxed);
+                if (validate_idle_sec < 0 || getCurrentTime() - conn->time_ < validate_idle_sec) {
+                    return conn;
+                }
+
+                // 空闲较久的连接先 ping 一次，失效则丢弃并由后台补充
+                if (validateConnection(*conn)) {
+                    return conn;
+                }
+                std::cerr << "借出前校验失败, 丢弃失效连接" << std::endl;
+                conn.reset();
+                discardConnection();
+                continue;
+            }
+
+            int current = nums_.load();
+            if (grow && current < max_conn_num_) {
+                if (!nums_.compare_exchange_weak(current, current + 1)) {
+                    continue;
+                }
+                try {
+                    auto conn = createConnection();
+                    std::cout << "连接池扩容, 当前连接数: " << nums_ << "/" << max_conn_num_ << std::endl;
+                    return conn;
+                } catch (const sql::SQLException& e) {
+                    std::cerr << "连接池扩容失败: " << e.what() << std::endl;
+                    std::cerr << "错误代码: " << e.getErrorCode() << std::endl;
+                    releaseSlot();
+                    noteFailure();
+                    if (breaker_.isOpen()) {
+                        requestScope::noteUnavailable();
+                        return nullptr;
+                    }
+                    grow = false;
+                    continue;
+                }
+            }
+
+            // 慢路径：登记为等待者后再检查一次，归还方看到等待者才会加锁通知
+            std::unique_lock<std::mutex> lock(conn_mutex_);
+            ++waiters_;
+            bool ready = conn_cond_.wait_until(lock, deadline, [this, grow]() {
+                return stop_ || idle_num_ > 0 || (grow && nums_ < max_conn_num_);
+            });
+            --waiters_;
+            if (!ready) {
+                std::cerr << "获取数据库连接超时 (" << timeout.count() << "ms)" << std::endl;
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    // 每个线程固定映射到一个分片，同一执行线程借还的连接留在本分片，互不争用
+    std::size_t homeShard() const {
+        static std::atomic<std::size_t> next_thread{0};
+        thread_local std::size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+        return thread_index % shards_.size();
+    }
+
+    // 先取本分片热端的连接，本分片为空时依次从其他分片窃取
+    std::unique_ptr<SqlConnection> takeIdle(std::size_t home) {
+        if (idle_num_.load() == 0) {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            Shard& shard = *shards_[(home + i) % shards_.size()];
+            if (shard.size.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!shard.ring.empty()) {
+                auto conn = shard.ring.popBack();
+                shard.size.store(static_cast<int>(shard.ring.size()), std::memory_order_relaxed);
+                --idle_num_;
+                return conn;
+            }
+        }
+        return nullptr;
+    }
+
+    // 放入空闲连接；cold 为 true 时放到冷端（保活检查后放回，不打乱热连接的顺序）
+    void pushIdle(std::size_t shard_index, std::unique_ptr<SqlConnection> conn, bool cold) {
+        Shard& shard = *shards_[shard_index];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (cold) {
+                shard.ring.pushFront(std::move(conn));
+            } else {
+                shard.ring.pushBack(std::move(conn));
+            }
+            shard.size.store(static_cast<int>(shard.ring.size()), std::memory_order_relaxed);
+        }
+        ++idle_num_;
+        notifyWaiter();
+    }
+
+    // idle_num_/nums_ 的修改与 waiters_ 的读取都是顺序一致的原子操作，
+    // 与等待方“先登记再检查”配合，不会漏掉唤醒
+    void notifyWaiter() {
+        if (waiters_.load() > 0) {
+            std::unique_lock<std::mutex> lock(conn_mutex_);
             conn_cond_.notify_one();
         }
     }
 
+public:
+    // healthy 为 false 表示使用过程中出错，连接下次借出前必须先校验
+    void releaseConnection(std::unique_ptr<SqlConnection> conn, bool healthy = true) {
+        if (!conn) {
+            return;
+        }
+        // 上限被调小后，多出的连接在归还时关闭
+        int current = nums_.load();
+        while (current > max_conn_num_.load(std::memory_order_relaxed)) {
+            if (nums_.compare_exchange_weak(current, current - 1)) {
+                conn.reset();
+                notifyWaiter();
+                return;
+            }
+        }
+        auto curr_time = getCurrentTime();
+        conn->last_used_ = curr_time;
+        conn->time_ = healthy ? curr_time : 0;
+        pushIdle(homeShard(), std::move(conn), false);
+    }
+
+    // 运行中调整连接池参数（配置热加载）。上限调大立即生效；调小时先关闭多出的空闲连接，
+    // 借出中的连接在归还时关闭。分片数、预热参数只在启动时生效
+    void reconfigure(const PoolOptions& options) {
+        int min_conn_num = std::max(1, options.min_conn_num);
+        int max_conn_num = std::max(min_conn_num, options.max_conn_num);
+        // 先扩大各分片的容量再公布新的上限，保证任何时刻连接总数不超过单个分片的容量
+        if (max_conn_num > max_conn_num_.load()) {
+            for (auto& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->ring.reserve(static_cast<std::size_t>(max_conn_num));
+            }
+        }
+        int previous_min = min_conn_num_.exchange(min_conn_num);
+        int previous_max = max_conn_num_.exchange(max_conn_num);
+        acquire_timeout_ms_ = std::max(0, options.acquire_timeout_ms);
+        idle_timeout_sec_ = options.idle_timeout_sec;
+        stmt_cache_size_ = static_cast<std::size_t>(std::max(0, options.stmt_cache_size));
+        keepalive_interval_sec_ = std::max(1, options.keepalive_interval_sec);
+        validate_idle_sec_ = options.validate_idle_sec;
+
+        if (previous_min != min_conn_num || previous_max != max_conn_num) {
+            std::cout << "连接池参数已更新: " << previous_min << "-" << previous_max 
+                      << " -> " << min_conn_num << "-" << max_conn_num << std::endl;
+        }
+        if (max_conn_num < previous_max) {
+            trimIdle();
+        } else if (max_conn_num > previous_max) {
+            notifyWaiter();
+        }
+        // 由维护线程补充到新的 min_conn_num，并按新的保活周期重新计时
+        {
+            std::unique_lock<std::mutex> lock(maint_mutex_);
+            refill_needed_ = true;
+        }
+        maint_cond_.notify_one();
+    }
+
+    int maxConnections() const {
+        return max_conn_num_.load();
+    }
+
+    // 健康检查：在连接池之外的专用连接上 ping 一次，连接池被请求占满时也能如实反映实例是否可用；
+    // 专用连接在两次检查之间保持打开，失效后下一次检查重建。熔断期间直接视为失败，恢复由熔断器探测
+    bool ping() {
+        if (breaker_.isOpen()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(probe_mutex_);
+        try {
+            if (!probe_conn_) {
+                probe_conn_ = std::make_unique<SqlConnection>(factory_(), getCurrentTime(), 0);
+            }
+            if (validateConnection(*probe_conn_)) {
+                return true;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "数据库 " << endpoint_ << " 健康检查建连失败: " << e.what() << std::endl;
+        }
+        probe_conn_.reset();
+        return false;
+    }
+
+    // 显式事务：构造时 START TRANSACTION，commit 提交。事务状态由本对象跟踪，
+    // 析构时只有仍未结束的事务才回滚；回滚失败说明连接已不可用，直接丢弃
     class Transaction {
     public:
-        Transaction(std::unique_ptr<SqlConnection> conn) : conn_(std::move(conn)) {
+        Transaction(mysqlDao* dao, std::unique_ptr<SqlConnection> conn) 
+            : dao_(dao), conn_(std::move(conn)) {
             if (conn_) {
-                conn_->conn_->setAutoCommit(false);
+                try {
+                    conn_->begin();
+                    active_ = true;
+                } catch (...) {
+                    conn_.reset();
+                    dao_->discardConnection();
+                    throw;
+                }
             }
         }
         
         ~Transaction() {
-            if (conn_) {
+            if (!conn_) {
+                return;
+            }
+            if (active_) {
                 try {
-                    conn_->conn_->rollback();
-                } catch (...) {}
-                conn_->conn_->setAutoCommit(true);
+                    conn_->rollback();
+                } catch (...) {
+                    conn_.reset();
+                    dao_->discardConnection();
+                    return;
+                }
             }
+            dao_->releaseConnection(std::move(conn_));
         }
         
+        // 提交失败时事务仍视为未结束，由析构回滚
         void commit() {
-            if (conn_) {
-                conn_->conn_->commit();
+            if (conn_ && active_) {
+                conn_->commit();
+                active_ = false;
             }
         }
+
+        void rollback() {
+            if (conn_ && active_) {
+                active_ = false;
+                conn_->rollback();
+            }
+        }
+
+        bool active() const {
+            return active_;
+        }
         
         sql::Connection* get() {
             return conn_ ? conn_->conn_ : nullptr;
         }
+
+        SqlConnection* connection() {
+            return conn_.get();
+        }
         
     private:
+        mysqlDao* dao_;
         std::unique_ptr<SqlConnection> conn_;
+        bool active_ = false;
+    };
+
+    // 非事务的连接借用，析构时归还连接池
+    class ConnectionGuard {
+    public:
+        ConnectionGuard(mysqlDao* dao, std::unique_ptr<SqlConnection> conn)
+            : dao_(dao), conn_(std::move(conn)) {}
+
+        ~ConnectionGuard() {
+            if (conn_) {
+                dao_->releaseConnection(std::move(conn_), healthy_);
+            }
+        }
+
+        SqlConnection* get() {
+            return conn_.get();
+        }
+
+        void markSuspect() {
+            healthy_ = false;
+        }
+
+    private:
+        mysqlDao* dao_;
+        std::unique_ptr<SqlConnection> conn_;
+        bool healthy_ = true;
     };
 
     template<typename T>
@@ -167,144 +729,615 @@ public:
     };
 
     Transaction beginTransaction() {
-        return Transaction(getConnection());
+        return Transaction(this, getConnection());
     }
 
     template<typename Func>
     bool executeInTransaction(Func&& func) {
-        auto transaction = beginTransaction();
-        if (!transaction.get()) {
-            return false;
-        }
-        
+        dbMetrics& metrics = dbMetrics::getInstance();
         try {
-            if (func(transaction.get())) {
+            // START TRANSACTION 失败时 Transaction 已丢弃连接，异常在下面统一处理
+            auto transaction = beginTransaction();
+            if (!transaction.get()) {
+                return false;
+            }
+            applyStatementTimeout(*transaction.connection());
+            auto start = std::chrono::steady_clock::now();
+            bool ok = func(transaction.connection());
+            auto executed = std::chrono::steady_clock::now();
+            metrics.execute_latency.record(executed - start);
+            // 客户端已经放弃的请求不再提交，由 Transaction 析构回滚
+            if (ok && requestAborted()) {
+                std::cerr << "请求已取消或超时, 事务回滚" << std::endl;
+                ok = false;
+            } else if (ok) {
                 transaction.commit();
-                return true;
+                metrics.commit_latency.record(std::chrono::steady_clock::now() - executed);
             }
+            noteSuccess();
+            return ok;
+        } catch (const sql::SQLException& e) {
+            std::cerr << "事务执行失败: " << e.what() << std::endl;
+            metrics.mysql_errors.record(e.getErrorCode());
+            noteSqlError(e);
         } catch (const std::exception& e) {
             std::cerr << "事务执行失败: " << e.what() << std::endl;
         }
         return false;
     }
 
+    // 单条语句的写操作：在自动提交模式下执行，语句本身即一个事务，只需一次往返。
+    // 执行后无法回滚，因此请求已取消或超时时在执行前放弃；func 只应执行一条写语句，
+    // 多条语句须保证原子性时使用 executeInTransaction
+    template<typename Func>
+    bool executeAutocommit(Func&& func) {
+        ConnectionGuard guard(this, getConnection());
+        if (!guard.get()) {
+            return false;
+        }
+        if (requestAborted()) {
+            std::cerr << "请求已取消或超时, 放弃写入" << std::endl;
+            return false;
+        }
+
+        dbMetrics& metrics = dbMetrics::getInstance();
+        try {
+            applyStatementTimeout(*guard.get());
+            auto start = std::chrono::steady_clock::now();
+            bool ok = func(guard.get());
+            metrics.execute_latency.record(std::chrono::steady_clock::now() - start);
+            noteSuccess();
+            return ok;
+        } catch (const sql::SQLException& e) {
+            std::cerr << "写操作执行失败: " << e.what() << std::endl;
+            metrics.mysql_errors.record(e.getErrorCode());
+            noteSqlError(e);
+            guard.markSuspect();
+        } catch (const std::exception& e) {
+            std::cerr << "写操作执行失败: " << e.what() << std::endl;
+            guard.markSuspect();
+        }
+        return false;
+    }
+
+    // 借用一个连接执行只读操作（自动提交模式，不开启事务）
+    template<typename Func>
+    bool executeWithConnection(Func&& func) {
+        ConnectionGuard guard(this, getConnection());
+        if (!guard.get()) {
+            return false;
+        }
+
+        dbMetrics& metrics = dbMetrics::getInstance();
+        try {
+            applyStatementTimeout(*guard.get());
+            auto start = std::chrono::steady_clock::now();
+            bool ok = func(guard.get());
+            metrics.execute_latency.record(std::chrono::steady_clock::now() - start);
+            noteSuccess();
+            return ok;
+        } catch (const sql::SQLException& e) {
+            std::cerr << "查询执行失败: " << e.what() << std::endl;
+            metrics.mysql_errors.record(e.getErrorCode());
+            noteSqlError(e);
+            guard.markSuspect();
+        } catch (const std::exception& e) {
+            std::cerr << "查询执行失败: " << e.what() << std::endl;
+            guard.markSuspect();
+        }
+        return false;
+    }
+
 private:
+    static ConnectionFactory driverFactory(const std::string &host, const std::string &user, 
+                                           const std::string &password, const std::string &database, 
+                                           const std::string &port) {
+        sql::Driver* driver = get_driver_instance();
+        std::string connection_url = "tcp://" + host + ":" + port;
+        return [driver, connection_url, user, password, database]() {
+            std::unique_ptr<sql::Connection> conn(driver->connect(connection_url, user, password));
+            conn->setSchema(database);
+            return conn.release();
+        };
+    }
+
+    static bool requestAborted() {
+        const requestScope* scope = requestScope::current();
+        return scope && scope->aborted();
+    }
+
+    // 说明数据库不可达的错误码：客户端侧的建连失败与连接中断（CR_*），
+    // 以及服务端的连接数已满、正在关闭、连接被终止。死锁、约束冲突、语句超时等说明数据库仍在工作
+    static bool isConnectionError(int code) {
+        switch (code) {
+            case 1040:  // ER_CON_COUNT_ERROR
+            case 1053:  // ER_SERVER_SHUTDOWN
+            case 1927:  // ER_CONNECTION_KILLED
+            case 2002:  // CR_CONNECTION_ERROR
+            case 2003:  // CR_CONN_HOST_ERROR
+            case 2005:  // CR_UNKNOWN_HOST
+            case 2006:  // CR_SERVER_GONE_ERROR
+            case 2013:  // CR_SERVER_LOST
+            case 2055:  // CR_SERVER_LOST_EXTENDED
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void noteSuccess() {
+        if (breaker_.onSuccess()) {
+            std::cout << "数据库 " << endpoint_ << " 已恢复, 熔断器闭合" << std::endl;
+        }
+    }
+
+    void noteSqlError(const sql::SQLException& e) {
+        if (isConnectionError(e.getErrorCode())) {
+            noteFailure();
+        } else {
+            noteSuccess();
+        }
+    }
+
+    // 熔断器因本次失败断开时，唤醒维护线程丢弃可能已失效的空闲连接并开始后台探测
+    void noteFailure() {
+        if (!breaker_.onFailure()) {
+            return;
+        }
+        std::cerr << "数据库 " << endpoint_ << " 不可用, 熔断器断开, " 
+                  << breaker_.retryAfter().count() << "ms 后开始后台探测" << std::endl;
+        std::unique_lock<std::mutex> lock(maint_mutex_);
+        refill_needed_ = true;
+        maint_cond_.notify_one();
+    }
+
+    // 把请求的剩余时间下发为会话级语句超时：max_execution_time 限制 SELECT 的执行时间，
+    // innodb_lock_wait_timeout（秒）限制写操作的锁等待。剩余时间按 1-2-5 档向上取整，
+    // 与连接上已下发的值相同时不产生额外往返；不在请求内时恢复服务端默认值。
+    // 服务端不支持（MySQL 5.7.8 以前、MariaDB）时记录一次并停用
+    void applyStatementTimeout(SqlConnection& conn) {
+        if (!statement_timeout_supported_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        long long timeout_ms = 0;
+        const requestScope* scope = requestScope::current();
+        if (scope && scope->hasDeadline()) {
+            timeout_ms = statementTimeoutBucket(scope->remaining().count());
+        }
+        if (timeout_ms == conn.statement_timeout_ms_) {
+            return;
+        }
+
+        std::string sql;
+        if (timeout_ms == 0) {
+            sql = "SET SESSION max_execution_time = @@GLOBAL.max_execution_time, "
+                  "innodb_lock_wait_timeout = @@GLOBAL.innodb_lock_wait_timeout";
+        } else {
+            sql = "SET SESSION max_execution_time = " + std::to_string(timeout_ms) +
+                  ", innodb_lock_wait_timeout = " + std::to_string((timeout_ms + 999) / 1000);
+        }
+        try {
+            std::unique_ptr<sql::Statement> stmt(conn.conn_->createStatement());
+            countRoundTrip();
+            phaseTimer timer(TracePhase::Execute);
+            stmt->execute(sql);
+            conn.statement_timeout_ms_ = timeout_ms;
+        } catch (const sql::SQLException& e) {
+            // 只有服务端不认识该变量（ER_UNKNOWN_SYSTEM_VARIABLE，如 MariaDB）才全局停用；
+            // 其他错误（断线、超时等）只说明这个连接有问题，交给调用方按执行失败处理
+            if (e.getErrorCode() != ER_UNKNOWN_SYSTEM_VARIABLE) {
+                throw;
+            }
+            if (statement_timeout_supported_.exchange(false)) {
+                std::cerr << "服务端不支持会话级语句超时, 已停用: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    static long long statementTimeoutBucket(long long remaining_ms) {
+        long long scale = 1;
+        while (true) {
+            for (long long step : {1, 2, 5}) {
+                if (remaining_ms <= step * scale) {
+                    return std::max<long long>(step * scale, MIN_STATEMENT_TIMEOUT_MS);
+                }
+            }
+            scale *= 10;
+        }
+    }
+
     long long getCurrentTime() {
         return std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()
         ).count();
     }
 
-    // 添加重试相关常量
+    // 建连成功后唤醒 waitWarmUp：预热结束时没有连接的情况下，之后的任何新连接都使连接池就绪
+    std::unique_ptr<SqlConnection> createConnection() {
+        sql::Connection* conn = factory_();
+        dbMetrics::getInstance().pool_created.fetch_add(1, std::memory_order_relaxed);
+        auto created = std::make_unique<SqlConnection>(conn, getCurrentTime(), stmt_cache_size_.load());
+        {
+            std::lock_guard<std::mutex> lock(warm_mutex_);
+            warm_cond_.notify_all();
+        }
+        return created;
+    }
+
+    void releaseSlot() {
+        --nums_;
+        notifyWaiter();
+    }
+
+    // 一次 ping 往返确认连接可用，调用方不得持有 conn_mutex_
+    bool validateConnection(SqlConnection& conn) {
+        try {
+            if (!conn.conn_) {
+                return false;
+            }
+            countRoundTrip();
+            if (conn.conn_->isValid()) {
+                conn.time_ = getCurrentTime();
+                return true;
+            }
+        } catch (const sql::SQLException& e) {
+            std::cerr << "连接校验失败: " << e.what() << std::endl;
+        }
+        return false;
+    }
+
+    // 后台维护线程：周期性收缩与保活，连接被丢弃时立即补充到 min_conn_num_；
+    // 熔断器断开期间只按退避节奏做恢复探测，不再保活与补充
+    void maintenanceLoop() {
+        auto next_check = std::chrono::steady_clock::now() + std::chrono::seconds(keepalive_interval_sec_.load());
+        std::unique_lock<std::mutex> lock(maint_mutex_);
+        while (!stop_) {
+            auto wake = next_check;
+            if (breaker_.isOpen()) {
+                wake = std::min(wake, breaker_.nextProbe());
+            }
+            maint_cond_.wait_until(lock, wake, [this]() { return stop_ || refill_needed_; });
+            if (stop_) {
+                break;
+            }
+            refill_needed_ = false;
+            lock.unlock();
+
+            if (breaker_.isOpen()) {
+                dropIdle();
+                if (std::chrono::steady_clock::now() >= breaker_.nextProbe()) {
+                    probeRecovery();
+                }
+                lock.lock();
+                continue;
+            }
+
+            if (std::chrono::steady_clock::now() >= next_check) {
+                shrinkIdle();
+                keepAlive();
+                next_check = std::chrono::steady_clock::now() + std::chrono::seconds(keepalive_interval_sec_.load());
+            }
+            refill();
+            // 保活周期被调短时按新周期提前检查
+            next_check = std::min(next_check, 
+                std::chrono::steady_clock::now() + std::chrono::seconds(keepalive_interval_sec_.load()));
+
+            lock.lock();
+        }
+    }
+
+    // 预热线程：领取序号，逐个建立常驻连接，直到 min_conn_num_ 个都已尝试
+    void warmUp() {
+        while (!stop_) {
+            int index = warm_next_.fetch_add(1);
+            if (index >= min_conn_num_) {
+                break;
+            }
+            // 请求可能已经按需扩容，占位不超过上限
+            int current = nums_.load();
+            do {
+                if (current >= max_conn_num_) {
+                    current = -1;
+                    break;
+                }
+            } while (!nums_.compare_exchange_weak(current, current + 1));
+            if (current < 0) {
+                break;
+            }
+
+            try {
+                pushIdle(static_cast<std::size_t>(index) % shards_.size(), createConnection(), false);
+                std::cout << "成功创建连接 #" << (index + 1) << std::endl;
+                std::lock_guard<std::mutex> lock(warm_mutex_);
+                ++warm_created_;
+                warm_cond_.notify_all();
+            } catch (const sql::SQLException &e) {
+                std::cerr << "连接 #" << (index + 1) << " 创建失败: " << e.what() << std::endl;
+                std::cerr << "错误代码: " << e.getErrorCode() << std::endl;
+                std::cerr << "SQL状态: " << e.getSQLState() << std::endl;
+                releaseSlot();
+            } catch (const std::exception &e) {
+                std::cerr << "连接 #" << (index + 1) << " 创建失败: " << e.what() << std::endl;
+                releaseSlot();
+            }
+        }
+        std::lock_guard<std::mutex> lock(warm_mutex_);
+        if (--warm_workers_ == 0) {
+            std::cout << "连接池预热完成, 当前连接数: " << nums_ << "/" << max_conn_num_ << std::endl;
+        }
+        warm_cond_.notify_all();
+    }
+
+    void joinWarmUp() {
+        for (auto& thread : warmup_threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    // 补充连接到 min_conn_num_
+    void refill() {
+        while (!stop_) {
+            int current = nums_.load();
+            if (current >= min_conn_num_) {
+                return;
+            }
+            if (!nums_.compare_exchange_weak(current, current + 1)) {
+                continue;
+            }
+            try {
+                releaseConnection(createConnection());
+                std::cout << "补充了新的连接, 当前连接数: " << nums_ << "/" << max_conn_num_ << std::endl;
+            } catch (const sql::SQLException& e) {
+                std::cerr << "补充新连接失败: " << e.what() << std::endl;
+                releaseSlot();
+                noteFailure();
+                return;
+            }
+        }
+    }
+
+    // 上限调小后立即关闭多出的空闲连接（从冷端开始）
+    void trimIdle() {
+        std::vector<std::unique_ptr<SqlConnection>> excess;
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            while (!shard.ring.empty()) {
+                int current = nums_.load();
+                if (current <= max_conn_num_.load() || !nums_.compare_exchange_strong(current, current - 1)) {
+                    break;
+                }
+                excess.push_back(shard.ring.popFront());
+                --idle_num_;
+            }
+            shard.size.store(static_cast<int>(shard.ring.size()), std::memory_order_relaxed);
+        }
+        if (!excess.empty()) {
+            std::cout << "连接池上限调小, 关闭空闲连接 " << excess.size() << " 个" << std::endl;
+        }
+    }
+
+    // 熔断器断开后，空闲连接大多已随数据库一起失效，全部关闭，恢复后由 refill 重建
+    void dropIdle() {
+        std::vector<std::unique_ptr<SqlConnection>> dropped;
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            while (!shard.ring.empty()) {
+                dropped.push_back(shard.ring.popFront());
+                --idle_num_;
+                --nums_;
+            }
+            shard.size.store(0, std::memory_order_relaxed);
+        }
+        if (!dropped.empty()) {
+            dbMetrics::getInstance().pool_discarded.fetch_add(dropped.size(), std::memory_order_relaxed);
+            std::cout << "熔断期间关闭空闲连接 " << dropped.size() << " 个" << std::endl;
+        }
+        // dropped 在锁外析构
+    }
+
+    // 熔断期间的恢复探测：新建一个连接并 ping 成功后转为半开，连接留在池中，再补充到 min_conn_num_；
+    // 失败则把探测间隔加倍（带抖动）。请求不参与探测，不会在建连超时上排队
+    void probeRecovery() {
+        int current = nums_.load();
+        bool reserved = current < max_conn_num_ && nums_.compare_exchange_strong(current, current + 1);
+        try {
+            auto conn = createConnection();
+            if (!validateConnection(*conn)) {
+                throw std::runtime_error("新连接 ping 失败");
+            }
+            if (reserved) {
+                pushIdle(0, std::move(conn), false);
+            }
+            breaker_.onProbeSuccess();
+            std::cout << "数据库 " << endpoint_ << " 探测成功, 熔断器转为半开" << std::endl;
+        } catch (const std::exception& e) {
+            if (reserved) {
+                releaseSlot();
+            }
+            auto delay = breaker_.onProbeFailure();
+            std::cerr << "数据库 " << endpoint_ << " 探测失败, " << delay.count() 
+                      << "ms 后重试: " << e.what() << std::endl;
+            return;
+        }
+        refill();
+    }
+
+    // 回收空闲超时的连接，直到连接总数回落到 min_conn_num_
+    void shrinkIdle() {
+        int idle_timeout_sec = idle_timeout_sec_.load();
+        if (idle_timeout_sec <= 0) {
+            return;
+        }
+        std::vector<std::unique_ptr<SqlConnection>> expired;
+        auto curr_time = getCurrentTime();
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            // 冷端是最久未使用的连接
+            while (!shard.ring.empty() && 
+                   curr_time - shard.ring.at(0).last_used_ >= idle_timeout_sec) {
+                int current = nums_.load();
+                if (current <= min_conn_num_ || !nums_.compare_exchange_strong(current, current - 1)) {
+                    break;
+                }
+                expired.push_back(shard.ring.popFront());
+                --idle_num_;
+            }
+            shard.size.store(static_cast<int>(shard.ring.size()), std::memory_order_relaxed);
+        }
+        if (!expired.empty()) {
+            std::cout << "回收空闲连接 " << expired.size() << " 个, 当前连接数: " 
+                      << nums_ << "/" << max_conn_num_ << std::endl;
+        }
+        // expired 在锁外析构，关闭连接不阻塞其他请求
+    }
+
+    static constexpr long long MIN_STATEMENT_TIMEOUT_MS = 10;
+    static constexpr int ER_UNKNOWN_SYSTEM_VARIABLE = 1193;
+
+    // 保活重连的重试次数与首次退避，之后每次加倍并加抖动
     static const int MAX_RETRY_ATTEMPTS = 3;
-    static const int RETRY_DELAY_MS = 1000;
+    static const int RETRY_DELAY_MS = 100;
 
-    bool tryReconnect(sql::Connection* conn) {
-        for (int attempt = 1; attempt <= MAX_RETRY_ATTEMPTS; ++attempt) {
+    // 在原 SqlConnection 上重建底层连接，缓存的预处理语句随旧连接一起失效；
+    // 全部失败时计入熔断器，熔断器已断开时不再重试
+    bool tryReconnect(SqlConnection& conn) {
+        // 先关闭旧连接
+        conn.reset(nullptr);
+
+        int delay_ms = RETRY_DELAY_MS;
+        for (int attempt = 1; attempt <= MAX_RETRY_ATTEMPTS && !stop_ && !breaker_.isOpen(); ++attempt) {
+            if (attempt > 1) {
+                std::this_thread::sleep_for(circuitBreaker::jittered(std::chrono::milliseconds(delay_ms)));
+                delay_ms *= 2;
+            }
             try {
                 std::cout << "尝试重新连接 (第 " << attempt << " 次)" << std::endl;
-                
-                // 先关闭旧连接
-                if (conn) {
-                    try {
-                        conn->close();
-                    } catch (...) {}
-                    delete conn;
-                }
 
                 // 创建新连接
-                std::string connection_url = "tcp://" + host_ + ":" + port_;
-                conn = driver_->connect(connection_url, user_, password_);
-                conn->setSchema(database_);
+                std::unique_ptr<sql::Connection> new_conn(factory_());
                 
                 // 测试连接
-                std::unique_ptr<sql::Statement> test_stmt(conn->createStatement());
+                std::unique_ptr<sql::Statement> test_stmt(new_conn->createStatement());
+                countRoundTrip();
                 test_stmt->execute("SELECT 1");
-                
+                test_stmt.reset();
+
+                conn.reset(new_conn.release());
+                conn.time_ = getCurrentTime();
+                dbMetrics::getInstance().pool_reconnects.fetch_add(1, std::memory_order_relaxed);
                 std::cout << "重新连接成功" << std::endl;
                 return true;
             } catch (const sql::SQLException& e) {
                 std::cerr << "重新连接尝试 " << attempt << " 失败: " << e.what() << std::endl;
                 std::cerr << "错误代码: " << e.getErrorCode() << std::endl;
                 std::cerr << "SQL状态: " << e.getSQLState() << std::endl;
-                
-                if (attempt < MAX_RETRY_ATTEMPTS) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
-                }
             } catch (const std::exception& e) {
                 std::cerr << "重新连接时发生未知错误: " << e.what() << std::endl;
-                if (attempt < MAX_RETRY_ATTEMPTS) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
-                }
             }
         }
+        noteFailure();
         return false;
     }
 
+    // 逐个校验空闲超过一个保活周期的连接：每次只在锁内取出一个连接，
+    // ping 与重连都在锁外进行，其余连接照常借出
     void keepAlive() {
-        std::unique_lock<std::mutex> lock(conn_mutex_);
-        auto curr_time = getCurrentTime();
-        std::queue<std::unique_ptr<SqlConnection>> temp_queue;
+        auto cycle_start = getCurrentTime();
+        int keepalive_interval_sec = keepalive_interval_sec_.load();
+        int checked = 0;
         int reconnect_count = 0;
-        bool had_failures = false;
-        
-        while (!conn_queue_.empty()) {
-            auto conn = std::move(conn_queue_.front());
-            conn_queue_.pop();
-            
-            try {
-                // 执行简单查询来保持连接
-                std::unique_ptr<sql::Statement> stmt(conn->conn_->createStatement());
-                stmt->execute("SELECT 1");
-                conn->time_ = curr_time;
-                temp_queue.push(std::move(conn));
-            } catch (const sql::SQLException& e) {
-                had_failures = true;
-                std::cerr << "连接保活失败: " << e.what() << std::endl;
-                
-                sql::Connection* new_conn = nullptr;
-                if (tryReconnect(new_conn)) {
-                    temp_queue.push(std::make_unique<SqlConnection>(new_conn, curr_time));
-                    reconnect_count++;
+        int dropped = 0;
+
+        while (!stop_ && !breaker_.isOpen()) {
+            std::unique_ptr<SqlConnection> conn;
+            std::size_t shard_index = 0;
+            for (; shard_index < shards_.size() && !conn; ++shard_index) {
+                Shard& shard = *shards_[shard_index];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (std::size_t i = 0; i < shard.ring.size(); ++i) {
+                    if (cycle_start - shard.ring.at(i).time_ >= keepalive_interval_sec) {
+                        conn = shard.ring.take(i);
+                        shard.size.store(static_cast<int>(shard.ring.size()), std::memory_order_relaxed);
+                        --idle_num_;
+                        break;
+                    }
                 }
             }
-        }
-        
-        conn_queue_ = std::move(temp_queue);
-        
-        if (had_failures) {
-            std::cout << "保活周期完成 - 重新连接成功数: " << reconnect_count 
-                     << ", 当前活动连接数: " << conn_queue_.size() << "/" << max_conn_num_ << std::endl;
-            
-            // 如果连接池严重不足，尝试补充
-            while (conn_queue_.size() < static_cast<std::size_t>(max_conn_num_ / 2)) {
-                try {
-                    std::string connection_url = "tcp://" + host_ + ":" + port_;
-                    sql::Connection* new_conn = driver_->connect(connection_url, user_, password_);
-                    new_conn->setSchema(database_);
-                    conn_queue_.push(std::make_unique<SqlConnection>(new_conn, curr_time));
-                    std::cout << "补充了新的连接" << std::endl;
-                } catch (const sql::SQLException& e) {
-                    std::cerr << "补充新连接失败: " << e.what() << std::endl;
-                    break;
-                }
+            if (!conn) {
+                break;
+            }
+
+            ++checked;
+            bool alive = validateConnection(*conn);
+            if (!alive) {
+                std::cerr << "连接保活失败, 尝试在后台重连" << std::endl;
+                alive = tryReconnect(*conn);
+                reconnect_count += alive ? 1 : 0;
+            }
+
+            if (alive) {
+                // 放回原分片的冷端，不打乱热连接的顺序
+                pushIdle(shard_index - 1, std::move(conn), true);
+            } else {
+                conn.reset();
+                releaseSlot();
+                dbMetrics::getInstance().pool_discarded.fetch_add(1, std::memory_order_relaxed);
+                ++dropped;
             }
         }
+
+        if (reconnect_count > 0 || dropped > 0) {
+            std::cout << "保活周期完成 - 检查: " << checked << ", 重新连接成功数: " << reconnect_count 
+                      << ", 丢弃: " << dropped << ", 当前连接数: " << nums_ << "/" << max_conn_num_ << std::endl;
+        }
     }
 
 private:
-    const int max_conn_num_ = 5;
-    std::string host_;
-    std::string user_;
-    std::string password_;
-    std::string database_;
-    std::string port_;
-    std::atomic<int> nums_;
+    // 以下参数可由 reconfigure 在运行中修改
+    std::atomic<int> min_conn_num_;
+    std::atomic<int> max_conn_num_;
+    std::atomic<int> acquire_timeout_ms_;
+    std::atomic<int> idle_timeout_sec_;
+    std::atomic<std::size_t> stmt_cache_size_;
+    std::atomic<int> keepalive_interval_sec_;
+    std::atomic<int> validate_idle_sec_;
+    ConnectionFactory factory_;
+    std::string endpoint_;
+    std::atomic<int> nums_;  // 已创建的连接总数（含借出中的连接）
     std::atomic<bool> stop_;
-    sql::Driver* driver_;
+    circuitBreaker breaker_;
+    std::atomic<bool> statement_timeout_supported_{true};
     
-    std::queue<std::unique_ptr<SqlConnection>> conn_queue_;
-    std::mutex conn_mutex_;
+    // 空闲连接按分片存放，每个分片一把独立的锁并单独占一条缓存行
+    struct alignas(64) Shard {
+        explicit Shard(std::size_t capacity) : ring(capacity) {}
+        std::mutex mutex;
+        connectionRing ring;
+        std::atomic<int> size{0};  // ring.size() 的副本，窃取时无锁跳过空分片
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<int> idle_num_{0};
+    std::atomic<int> waiters_{0};
+    std::mutex conn_mutex_;  // 只在没有空闲连接、需要等待时使用
     std::condition_variable conn_cond_;
     std::thread keep_alive_thread_;
+    std::mutex maint_mutex_;
+    std::condition_variable maint_cond_;
+    bool refill_needed_ = false;
+
+    // 启动预热
+    std::vector<std::thread> warmup_threads_;
+    std::atomic<int> warm_next_{0};
+    std::mutex warm_mutex_;
+    std::condition_variable warm_cond_;
+    int warm_workers_ = 0;   // 仍在运行的预热线程数
+    int warm_created_ = 0;   // 预热阶段建好的连接数
+    std::mutex probe_mutex_;
+    std::unique_ptr<SqlConnection> probe_conn_;  // 健康检查专用连接，不计入连接池
 };
@@ -1,56 +1,468 @@
 #pragma once
 #include "mysqlDao.h"
-#include "configMgr.h"
+#include "replicaSet.h"
+#include "tableSchema.h"
+#include <algorithm>
+#include <future>
+#include <limits>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 批量操作中的单条写操作
+struct BatchOp {
+    enum class Type { Insert, Update, Delete };
+    Type type;
+    std::string name;
+    int age;
+};
+
+// 单条操作的执行结果，与 BatchOp 一一对应
+struct BatchOpResult {
+    bool success = false;
+    std::string message;
+};
+
+// 查询条件：name 前缀与 age 闭区间，max_age <= 0 表示不限上界
+struct QueryFilter {
+    std::string name_prefix;
+    int min_age = 0;
+    int max_age = 0;
+};
+
+// 键集游标：从 (name, age, id) 严格之后的位置继续扫描
+struct KeysetCursor {
+    bool valid = false;
+    std::string name;
+    int age = 0;
+    int64_t id = 0;
+};
+
+struct UserRow {
+    std::string name;
+    int age;
+    int64_t id;  // 自增主键，只用于推进键集游标
+};
+
+// 用户表 test(name, age)：name 为键列，age 为值列；另有自增主键 id，只在分页查询中用作排序键。mysqlMgr 的语句文本、参数绑定与结果解码均由它生成
+inline constexpr char USER_TABLE[] = "test";
+inline constexpr char USER_NAME_COLUMN[] = "name";
+inline constexpr char USER_AGE_COLUMN[] = "age";
+using userTable = tableSchema<USER_TABLE,
+                              schemaColumn<USER_NAME_COLUMN, std::string, true>,
+                              schemaColumn<USER_AGE_COLUMN, int>>;
+using userSql = tableSql<userTable>;
+
+static_assert(userSql::INSERT.view() == "INSERT INTO test (name, age) VALUES (?, ?)");
+static_assert(userSql::UPDATE.view() == "UPDATE test SET age = ? WHERE name = ?");
+static_assert(userSql::DELETE.view() == "DELETE FROM test WHERE name = ? AND age = ?");
+static_assert(userSql::SELECT_BY_KEY.view() == "SELECT age FROM test WHERE name = ? ORDER BY age");
+static_assert(userSql::SELECT_ALL.view() == "SELECT name, age FROM test");  // 分页查询的前两列
+
+// 一个 MySQL 实例的连接参数与连接池参数
+struct MysqlEndpoint {
+    std::string name;      // 日志与指标中的名称，如 mysql_replica_1(host:port)
+    std::string host;
+    std::string port;
+    std::string user;
+    std::string password;
+    std::string database;
+    PoolOptions pool;
+};
+
+// config.ini 中 [mysql]、[mysql_replica_N]、[replica] 与 [breaker] 部分
+struct MysqlConfig {
+    MysqlEndpoint primary;
+    std::vector<MysqlEndpoint> replicas;
+    ReplicaOptions replica;
+    BreakerOptions breaker;  // 主库与每个只读副本各用一个熔断器
+};
 
 class mysqlMgr {
 public:
-    mysqlMgr() {
-        configMgr& config = configMgr::getInstance();
-        std::string host = config.getValue("mysql", "host");
-        std::string user = config.getValue("mysql", "user");
-        std::string password = config.getValue("mysql", "password");
-        std::string database = config.getValue("mysql", "database");
-        std::string port = config.getValue("mysql", "port");
-        
-        mysqlPool_ = std::make_unique<mysqlDao>(host, user, password, database, port);
+    // 主库与各只读副本的连接池同时预热；副本不可用不影响启动
+    explicit mysqlMgr(const MysqlConfig& config) {
+        std::vector<std::pair<std::string, std::future<std::unique_ptr<mysqlDao>>>> pending;
+        for (const MysqlEndpoint& endpoint : config.replicas) {
+            replica_names_.push_back(endpoint.name);
+            pending.emplace_back(endpoint.name, std::async(std::launch::async, [endpoint, breaker = config.breaker]() {
+                return std::make_unique<mysqlDao>(endpoint.host, endpoint.user, endpoint.password,
+                                                  endpoint.database, endpoint.port, endpoint.pool,
+                                                  breaker);
+            }));
+        }
+
+        const MysqlEndpoint& primary_endpoint = config.primary;
+        std::unique_ptr<mysqlDao> primary;
+        std::string primary_error;
+        try {
+            primary = std::make_unique<mysqlDao>(primary_endpoint.host, primary_endpoint.user, 
+                                                 primary_endpoint.password, primary_endpoint.database, 
+                                                 primary_endpoint.port, primary_endpoint.pool,
+                                                 config.breaker);
+        } catch (const std::exception& e) {
+            primary_error = e.what();
+        }
+
+        std::vector<std::pair<std::string, std::unique_ptr<mysqlDao>>> replicas;
+        for (auto& replica : pending) {
+            try {
+                replicas.emplace_back(replica.first, replica.second.get());
+            } catch (const std::exception& e) {
+                // 副本不可用不影响启动，读请求全部走主库
+                std::cerr << "只读副本 " << replica.first << " 初始化失败, 已跳过: " << e.what() << std::endl;
+            }
+        }
+        if (!primary) {
+            throw std::runtime_error(primary_error);
+        }
+        mysqlPool_ = std::move(primary);
+        if (!replicas.empty()) {
+            replicas_ = std::make_unique<replicaSet>(std::move(replicas), config.replica);
+            std::cout << "读写分离已启用: " << replicas_->size() << " 个只读副本" << std::endl;
+        }
     }
     
+    // 直接使用已建好的主库连接池，不启用只读副本；
+    // 基准与分配计数检查用它接入 fakeDriver 的连接池
+    explicit mysqlMgr(std::unique_ptr<mysqlDao> primary) : mysqlPool_(std::move(primary)) {}
+    
     ~mysqlMgr() {}
 
-    bool insert(const std::string& name, int age) {
-        return mysqlPool_->executeInTransaction([&](sql::Connection* conn) {
-            mysqlDao::QueryGuard pstmt(std::unique_ptr<sql::PreparedStatement>(
-                conn->prepareStatement("INSERT INTO test (name, age) VALUES (?, ?)")
-            ));
-            pstmt->setString(1, name);
-            pstmt->setInt(2, age);
-            return pstmt->executeUpdate() > 0;
+    // 连接池上限，用于确定数据库执行线程数
+    int poolSize() const {
+        return mysqlPool_->maxConnections();
+    }
+
+    // 热加载：把新的连接池参数应用到主库与只读副本。副本按配置中的编号对应启动时的副本，
+    // 名称含 host:port，地址变更后按名称对应不上；地址、账号与副本的增减需要重启才能生效
+    void reconfigure(const MysqlConfig& config) {
+        mysqlPool_->reconfigure(config.primary.pool);
+        if (replicas_) {
+            replicas_->forEachPool([this, &config](const std::string& name, mysqlDao& pool) {
+                for (std::size_t i = 0; i < replica_names_.size() && i < config.replicas.size(); ++i) {
+                    if (replica_names_[i] == name) {
+                        pool.reconfigure(config.replicas[i].pool);
+                    }
+                }
+            });
+        }
+    }
+
+    mysqlDao::PoolStats poolStats() {
+        return mysqlPool_->stats();
+    }
+
+    // 主库连接池的启动预热是否完成；只读副本不影响就绪状态
+    bool waitWarmUp(std::chrono::milliseconds timeout) {
+        return mysqlPool_->waitWarmUp(timeout);
+    }
+
+    std::vector<replicaSet::ReplicaStats> replicaStats() const {
+        return replicas_ ? replicas_->stats() : std::vector<replicaSet::ReplicaStats>();
+    }
+
+    // 主库熔断器断开时写请求无法执行
+    bool writable() const {
+        return mysqlPool_->available();
+    }
+
+    // 读请求还可以交给未断开的只读副本
+    bool readable() const {
+        return writable() || (replicas_ && replicas_->anyAvailable());
+    }
+
+    // 主库熔断器下一次后台探测前的时长，作为客户端重试的建议间隔
+    std::chrono::milliseconds retryAfter() const {
+        return mysqlPool_->breaker().retryAfter();
+    }
+
+    // 读请求的重试建议间隔：主库或任一副本的下一次探测，取最早的一个
+    std::chrono::milliseconds readRetryAfter() const {
+        return replicas_ ? std::min(retryAfter(), replicas_->retryAfter()) : retryAfter();
+    }
+
+    const circuitBreaker& breaker() const {
+        return mysqlPool_->breaker();
+    }
+
+    // 会话写入完成后调用，随后 max_lag_ms 内该会话的读请求走主库
+    void noteWrite(std::string_view session) {
+        if (replicas_ && !session.empty()) {
+            replicas_->noteWrite(session);
+        }
+    }
+
+    // 单行写操作在自动提交模式下执行，每次请求与 MySQL 只有一次往返（预处理语句已缓存时）
+    bool insert(std::string_view name, int age) {
+        return mysqlPool_->executeAutocommit([&](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare(userSql::INSERT.view());
+            userTable::bindRow(pstmt, {name, age});
+            return executeUpdate(pstmt) > 0;
+        });
+    }
+
+    bool update(std::string_view name, int age) {
+        return mysqlPool_->executeAutocommit([&](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare(userSql::UPDATE.view());
+            userTable::bindUpdate(pstmt, {name, age});
+            return executeUpdate(pstmt) > 0;
         });
     }
 
-    bool update(const std::string& name, int age) {
-        return mysqlPool_->executeInTransaction([&](sql::Connection* conn) {
-            mysqlDao::QueryGuard pstmt(std::unique_ptr<sql::PreparedStatement>(
-                conn->prepareStatement("UPDATE test SET age = ? WHERE name = ?")
-            ));
-            pstmt->setInt(1, age);
-            pstmt->setString(2, name);
-            return pstmt->executeUpdate() > 0;
+    bool deleteData(std::string_view name, int age) {
+        return mysqlPool_->executeAutocommit([&](SqlConnection* conn) {
+            sql::PreparedStatement* pstmt = conn->prepare(userSql::DELETE.view());
+            userTable::bindRow(pstmt, {name, age});
+            return executeUpdate(pstmt) > 0;
         });
     }
 
-    bool deleteData(const std::string& name, int age) {
-        return mysqlPool_->executeInTransaction([&](sql::Connection* conn) {
-            mysqlDao::QueryGuard pstmt(std::unique_ptr<sql::PreparedStatement>(
-                conn->prepareStatement("DELETE FROM test WHERE name = ? AND age = ?")
-            ));
-            pstmt->setString(1, name);
-            pstmt->setInt(2, age);
-            return pstmt->executeUpdate() > 0;
+    // 在同一连接、同一事务中执行一批写操作，连续的 INSERT 合并为多行 VALUES 语句
+    // atomic 为 true 时任一操作失败整体回滚；否则失败的操作单独报告，其余照常提交
+    // 返回事务是否已提交，results 按顺序给出每条操作的结果
+    bool executeBatch(const std::vector<BatchOp>& ops, bool atomic, 
+                      std::vector<BatchOpResult>& results) {
+        results.assign(ops.size(), BatchOpResult());
+        if (ops.empty()) {
+            return true;
+        }
+
+        bool committed = mysqlPool_->executeInTransaction([&](SqlConnection* conn) {
+            std::size_t i = 0;
+            while (i < ops.size()) {
+                if (ops[i].type == BatchOp::Type::Insert) {
+                    std::size_t end = i;
+                    while (end < ops.size() && ops[end].type == BatchOp::Type::Insert) {
+                        ++end;
+                    }
+                    // 按固定行数切分，每个连接最多缓存 INSERT_BUCKETS 种多行语句
+                    while (i < end) {
+                        std::size_t rows = insertBucket(end - i);
+                        if (!insertRows(conn, ops, i, i + rows, atomic, results) && atomic) {
+                            return false;
+                        }
+                        i += rows;
+                    }
+                } else {
+                    if (!applyOp(conn, ops[i], results[i]) && atomic) {
+                        return false;
+                    }
+                    ++i;
+                }
+            }
+            return true;
+        });
+
+        if (!committed) {
+            for (auto& result : results) {
+                if (result.success || result.message.empty()) {
+                    result.success = false;
+                    result.message = "事务已回滚";
+                }
+            }
+        }
+        return committed;
+    }
+
+    // 点查：读取 name 下所有记录的 age，按 age 升序
+    // from_replica 非空时返回本次结果是否来自只读副本（可能落后于主库）
+    bool findByName(std::string_view name, std::vector<int>& ages, 
+                    std::string_view session = {}, bool* from_replica = nullptr) {
+        return executeRead(session, from_replica, [&](SqlConnection* conn) {
+            ages.clear();
+            sql::PreparedStatement* pstmt = conn->prepare(userSql::SELECT_BY_KEY.view());
+            userTable::bindKey(pstmt, {name});
+            std::unique_ptr<sql::ResultSet> rs(executeQuery(pstmt));
+            while (rs->next()) {
+                userTable::decodeValues(rs.get(), [&ages](int age) { ages.push_back(age); });
+            }
+            return true;
+        });
+    }
+
+    // 按 (name, age, id) 顺序读取游标之后的最多 limit 行到 rows（复用调用方的缓冲），
+    // 调用方逐页推进游标，内存占用只与页大小有关；
+    // 自增主键 id 作为最后一个排序键，(name, age) 完全相同的记录跨页时续传也不会跳过或重复。
+    // 过滤条件始终出现在语句中，未指定的条件绑定不起作用的值，
+    // 语句文本只有首页与续页两种，不会随过滤组合挤占连接上的预处理语句缓存
+    bool queryPage(const QueryFilter& filter, const KeysetCursor& after, int limit,
+                   std::vector<UserRow>& rows, std::string_view session = {}) {
+        return executeRead(session, nullptr, [&](SqlConnection* conn) {
+            rows.clear();
+            sql::PreparedStatement* pstmt = conn->prepare(after.valid ? QUERY_NEXT_PAGE : QUERY_FIRST_PAGE);
+            unsigned int index = 1;
+            pstmt->setString(index++, escapeLike(filter.name_prefix) + "%");
+            pstmt->setInt(index++, filter.min_age > 0 ? filter.min_age : std::numeric_limits<int>::min());
+            pstmt->setInt(index++, filter.max_age > 0 ? filter.max_age : std::numeric_limits<int>::max());
+            if (after.valid) {
+                pstmt->setString(index++, after.name);
+                pstmt->setString(index++, after.name);
+                pstmt->setInt(index++, after.age);
+                pstmt->setInt(index++, after.age);
+                pstmt->setInt64(index++, after.id);
+            }
+            pstmt->setInt(index++, limit);
+
+            std::unique_ptr<sql::ResultSet> rs(executeQuery(pstmt));
+            while (rs->next()) {
+                int64_t id = rs->getInt64(3);
+                userTable::decodeRow(rs.get(), [&rows, id](std::string&& name, int age) {
+                    rows.push_back(UserRow{std::move(name), age, id});
+                });
+            }
+            return true;
         });
     }
 
 private:
+    // 只读操作的路由：会话处于写后粘滞期或没有健康副本时走主库，否则交给在途请求最少的副本；
+    // 副本上执行失败时在主库上重试一次（读操作可安全重放）
+    template<typename Func>
+    bool executeRead(std::string_view session, bool* from_replica, Func&& func) {
+        if (from_replica) {
+            *from_replica = false;
+        }
+        if (replicas_ && (session.empty() || !replicas_->isSticky(session))) {
+            replicaSet::Lease lease = replicas_->acquire();
+            if (lease.dao()) {
+                if (lease.dao()->executeWithConnection(func)) {
+                    if (from_replica) {
+                        *from_replica = true;
+                    }
+                    return true;
+                }
+                std::cerr << "只读副本 " << lease.name() << " 读取失败, 改由主库执行" << std::endl;
+            }
+        }
+        return mysqlPool_->executeWithConnection(func);
+    }
+
+    // 分页查询在表的列之后读取自增主键 id，作为键集游标的最后一个排序键
+    static constexpr std::string_view QUERY_FIRST_PAGE =
+        "SELECT name, age, id FROM test WHERE name LIKE ? AND age >= ? AND age <= ?"
+        " ORDER BY name, age, id LIMIT ?";
+    static constexpr std::string_view QUERY_NEXT_PAGE =
+        "SELECT name, age, id FROM test WHERE name LIKE ? AND age >= ? AND age <= ?"
+        " AND (name > ? OR (name = ? AND (age > ? OR (age = ? AND id > ?))))"
+        " ORDER BY name, age, id LIMIT ?";
+
+    // 转义 LIKE 通配符，使前缀按字面匹配
+    static std::string escapeLike(const std::string& value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            if (c == '%' || c == '_' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // 多行 INSERT 只使用这几种行数：最大 500 行，控制语句长度与占位符数量；
+    // 行数固定后语句文本只有几种，不会挤占连接上的预处理语句缓存
+    static constexpr std::size_t INSERT_BUCKETS[] = {500, 100, 20, 5, 1};
+
+    // 不超过 rows 的最大档位
+    static std::size_t insertBucket(std::size_t rows) {
+        for (std::size_t bucket : INSERT_BUCKETS) {
+            if (bucket <= rows) {
+                return bucket;
+            }
+        }
+        return 1;
+    }
+
+    static bool isTransactionAborted(const sql::SQLException& e) {
+        // 死锁会回滚整个事务，之后的语句已经没有意义
+        return e.getErrorCode() == 1213;
+    }
+
+    bool applyOp(SqlConnection* conn, const BatchOp& op, BatchOpResult& result) {
+        try {
+            sql::PreparedStatement* pstmt = nullptr;
+            switch (op.type) {
+                case BatchOp::Type::Insert:
+                    pstmt = conn->prepare(userSql::INSERT.view());
+                    userTable::bindRow(pstmt, {op.name, op.age});
+                    break;
+                case BatchOp::Type::Update:
+                    pstmt = conn->prepare(userSql::UPDATE.view());
+                    userTable::bindUpdate(pstmt, {op.name, op.age});
+                    break;
+                case BatchOp::Type::Delete:
+                    pstmt = conn->prepare(userSql::DELETE.view());
+                    userTable::bindRow(pstmt, {op.name, op.age});
+                    break;
+            }
+            result.success = executeUpdate(pstmt) > 0;
+            result.message = result.success ? "成功" : "未影响任何记录";
+        } catch (const sql::SQLException& e) {
+            if (isTransactionAborted(e)) {
+                throw;
+            }
+            dbMetrics::getInstance().mysql_errors.record(e.getErrorCode());
+            result.success = false;
+            result.message = e.what();
+        }
+        return result.success;
+    }
+
+    // 执行 ops[begin, end) 中的 INSERT；多行语句失败时（整条语句已回滚）
+    // 在尽力模式下逐行重试以定位失败的记录
+    bool insertRows(SqlConnection* conn, const std::vector<BatchOp>& ops,
+                    std::size_t begin, std::size_t end, bool atomic,
+                    std::vector<BatchOpResult>& results) {
+        std::size_t rows = end - begin;
+        if (rows == 1) {
+            return applyOp(conn, ops[begin], results[begin]);
+        }
+
+        std::string sql(userSql::INSERT_PREFIX.view());
+        sql.reserve(sql.size() + rows * (userSql::ROW.size + 2));
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (i > 0) {
+                sql += ", ";
+            }
+            sql += userSql::ROW.view();
+        }
+
+        try {
+            sql::PreparedStatement* pstmt = conn->prepare(sql);
+            unsigned int index = 1;
+            for (std::size_t i = begin; i < end; ++i) {
+                index = userTable::bindRow(pstmt, {ops[i].name, ops[i].age}, index);
+            }
+            bool ok = executeUpdate(pstmt) == static_cast<int>(rows);
+            for (std::size_t i = begin; i < end; ++i) {
+                results[i].success = ok;
+                results[i].message = ok ? "成功" : "插入行数不符";
+            }
+            return ok;
+        } catch (const sql::SQLException& e) {
+            if (isTransactionAborted(e)) {
+                throw;
+            }
+            dbMetrics::getInstance().mysql_errors.record(e.getErrorCode());
+            if (atomic) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    results[i].success = false;
+                    results[i].message = e.what();
+                }
+                return false;
+            }
+        }
+
+        bool all_ok = true;
+        for (std::size_t i = begin; i < end; ++i) {
+            all_ok = applyOp(conn, ops[i], results[i]) && all_ok;
+        }
+        return all_ok;
+    }
+
     std::unique_ptr<mysqlDao> mysqlPool_;
+    std::unique_ptr<replicaSet> replicas_;  // 未配置副本时为空
+    std::vector<std::string> replica_names_;  // 启动时各副本的名称，按配置中的编号排列
 };
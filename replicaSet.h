@@ -0,0 +1,282 @@
+#pragma once
+#include "mysqlDao.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 只读副本参数，对应 config.ini 的 [replica] 部分
+struct ReplicaOptions {
+    int health_interval_ms = 1000;    // health_interval_ms: 健康检查周期
+    int eject_after_failures = 2;     // eject_after_failures: 连续失败多少次后摘除
+    int readmit_after_successes = 2;  // readmit_after_successes: 摘除后连续成功多少次恢复
+    int max_lag_ms = 1000;            // max_lag_ms: 会话写入后该时长内的读请求固定走主库
+};
+
+// 一组只读副本：读请求按最少在途请求数选择副本，健康检查失败的副本被摘除，
+// 会话写入后的一段时间内读请求回到主库以保证读到自己的写入
+class replicaSet {
+    struct Replica;
+
+public:
+    // 借用期间计入副本的在途请求数，析构时归还
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept : replica_(other.replica_) {
+            other.replica_ = nullptr;
+        }
+        ~Lease() {
+            if (replica_) {
+                replica_->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        mysqlDao* dao() const {
+            return replica_ ? replica_->pool.get() : nullptr;
+        }
+
+        const std::string& name() const {
+            return replica_->name;
+        }
+
+    private:
+        friend class replicaSet;
+        Replica* replica_ = nullptr;
+    };
+
+    struct ReplicaStats {
+        std::string name;
+        bool healthy;
+        int outstanding;
+        uint64_t reads;
+        uint64_t ejections;
+        circuitBreaker::Snapshot breaker;
+    };
+
+    replicaSet(std::vector<std::pair<std::string, std::unique_ptr<mysqlDao>>> pools,
+               const ReplicaOptions& options)
+        : options_(options) {
+        for (auto& pool : pools) {
+            auto replica = std::make_unique<Replica>();
+            replica->name = std::move(pool.first);
+            replica->pool = std::move(pool.second);
+            replicas_.push_back(std::move(replica));
+        }
+        health_thread_ = std::thread([this]() { healthLoop(); });
+    }
+
+    ~replicaSet() {
+        {
+            std::unique_lock<std::mutex> lock(health_mutex_);
+            stop_ = true;
+        }
+        health_cond_.notify_all();
+        if (health_thread_.joinable()) {
+            health_thread_.join();
+        }
+    }
+
+    // 选出在途请求最少的健康副本（熔断器断开的副本同样跳过）；全部不可用时返回空租约，调用方改走主库
+    Lease acquire() {
+        Lease lease;
+        std::size_t count = replicas_.size();
+        // 轮转起点，在途数相同时把请求摊开
+        std::size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+        Replica* best = nullptr;
+        int best_outstanding = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            Replica* replica = replicas_[(start + i) % count].get();
+            if (!replica->healthy.load(std::memory_order_relaxed) || !replica->pool->available()) {
+                continue;
+            }
+            int outstanding = replica->outstanding.load(std::memory_order_relaxed);
+            if (!best || outstanding < best_outstanding) {
+                best = replica;
+                best_outstanding = outstanding;
+            }
+        }
+        if (best) {
+            best->outstanding.fetch_add(1, std::memory_order_relaxed);
+            best->reads.fetch_add(1, std::memory_order_relaxed);
+            lease.replica_ = best;
+        }
+        return lease;
+    }
+
+    // 是否还有可以接收读请求的副本（健康且熔断器未断开）
+    bool anyAvailable() const {
+        for (const auto& replica : replicas_) {
+            if (replica->healthy.load(std::memory_order_relaxed) && replica->pool->available()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 熔断器断开的副本中最早一次后台探测前的时长；没有断开的副本时返回 milliseconds::max()。
+    // 被健康检查摘除的副本何时恢复取决于健康检查，不参与计算
+    std::chrono::milliseconds retryAfter() const {
+        auto after = std::chrono::milliseconds::max();
+        for (const auto& replica : replicas_) {
+            const circuitBreaker& breaker = replica->pool->breaker();
+            if (breaker.isOpen()) {
+                after = std::min(after, breaker.retryAfter());
+            }
+        }
+        return after;
+    }
+
+    // 记录会话的一次写入，max_lag_ms 内该会话的读请求走主库。
+    // 已登记的会话只更新到期时间，不复制会话 ID，写路径上没有堆分配
+    void noteWrite(std::string_view session) {
+        if (session.empty() || options_.max_lag_ms <= 0) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        StickyShard& shard = stickyShardFor(session);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        purgeExpired(shard, now);
+        auto until = now + std::chrono::milliseconds(options_.max_lag_ms);
+        auto it = shard.until.find(session);
+        if (it != shard.until.end()) {
+            it->second = until;
+            return;
+        }
+        it = shard.until.emplace(std::string(session), until).first;
+        shard.order.emplace_back(until, &it->first);
+    }
+
+    bool isSticky(std::string_view session) {
+        if (session.empty() || options_.max_lag_ms <= 0) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        StickyShard& shard = stickyShardFor(session);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.until.find(session);
+        return it != shard.until.end() && it->second > now;
+    }
+
+    std::vector<ReplicaStats> stats() const {
+        std::vector<ReplicaStats> result;
+        for (const auto& replica : replicas_) {
+            result.push_back(ReplicaStats{
+                replica->name,
+                replica->healthy.load(std::memory_order_relaxed),
+                replica->outstanding.load(std::memory_order_relaxed),
+                replica->reads.load(std::memory_order_relaxed),
+                replica->ejections.load(std::memory_order_relaxed),
+                replica->pool->breaker().snapshot()});
+        }
+        return result;
+    }
+
+    std::size_t size() const {
+        return replicas_.size();
+    }
+
+    // 逐个访问副本的连接池，用于热加载连接池参数
+    void forEachPool(const std::function<void(const std::string&, mysqlDao&)>& func) {
+        for (auto& replica : replicas_) {
+            func(replica->name, *replica->pool);
+        }
+    }
+
+private:
+    static const int STICKY_SHARDS = 16;
+
+    struct StickyShard {
+        std::mutex mutex;
+        // 透明比较器：按 string_view 查找，不为查找构造 std::string
+        std::map<std::string, std::chrono::steady_clock::time_point, std::less<>> until;
+        // 用于惰性清理，每个会话恰好一项，指向 until 中的键；到期时间以 until 中的值为准，
+        // 期间又有写入的会话清理时按新的到期时间重新排到队尾
+        std::deque<std::pair<std::chrono::steady_clock::time_point, const std::string*>> order;
+    };
+
+    StickyShard& stickyShardFor(std::string_view session) {
+        return sticky_[std::hash<std::string_view>()(session) % STICKY_SHARDS];
+    }
+
+    static void purgeExpired(StickyShard& shard, std::chrono::steady_clock::time_point now) {
+        while (!shard.order.empty() && shard.order.front().first <= now) {
+            auto it = shard.until.find(*shard.order.front().second);
+            shard.order.pop_front();
+            if (it->second <= now) {
+                shard.until.erase(it);
+            } else {
+                shard.order.emplace_back(it->second, &it->first);
+            }
+        }
+    }
+
+    // 逐个在专用连接上 ping 副本，请求占满连接池不影响判断；连续失败达到阈值摘除，摘除后连续成功达到阈值恢复
+    void healthLoop() {
+        std::unique_lock<std::mutex> lock(health_mutex_);
+        while (!stop_) {
+            health_cond_.wait_for(lock, std::chrono::milliseconds(std::max(10, options_.health_interval_ms)),
+                                  [this]() { return stop_; });
+            if (stop_) {
+                break;
+            }
+            lock.unlock();
+
+            for (auto& replica : replicas_) {
+                bool ok = replica->pool->ping();
+                bool healthy = replica->healthy.load(std::memory_order_relaxed);
+                if (ok) {
+                    replica->failures = 0;
+                    if (!healthy && ++replica->successes >= options_.readmit_after_successes) {
+                        replica->successes = 0;
+                        replica->healthy.store(true, std::memory_order_relaxed);
+                        std::cout << "只读副本恢复: " << replica->name << std::endl;
+                    }
+                } else {
+                    replica->successes = 0;
+                    if (healthy && ++replica->failures >= options_.eject_after_failures) {
+                        replica->failures = 0;
+                        replica->healthy.store(false, std::memory_order_relaxed);
+                        replica->ejections.fetch_add(1, std::memory_order_relaxed);
+                        std::cerr << "只读副本健康检查失败, 已摘除: " << replica->name << std::endl;
+                    }
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+    struct Replica {
+        std::string name;
+        std::unique_ptr<mysqlDao> pool;
+        std::atomic<bool> healthy{true};
+        std::atomic<int> outstanding{0};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> ejections{0};
+        int failures = 0;   // 仅健康检查线程访问
+        int successes = 0;
+    };
+
+    const ReplicaOptions options_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::atomic<std::size_t> next_{0};
+    StickyShard sticky_[STICKY_SHARDS];
+
+    std::thread health_thread_;
+    std::mutex health_mutex_;
+    std::condition_variable health_cond_;
+    bool stop_ = false;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include "requestTrace.h"
+
+// 当前请求的截止时间与取消状态，由 RPC 入口在执行数据库操作的线程上设置；
+// 数据库层据此缩短借出连接的等待、下发语句超时，并放弃客户端已经不再等待的工作。
+// 作用域按线程嵌套，析构时恢复外层的作用域。携带追踪上下文时，数据库层把各阶段耗时与 SQL 记入其中；
+// 内层作用域未指定追踪上下文时沿用外层的
+class requestScope {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    requestScope(Clock::time_point deadline, std::function<bool()> cancelled, requestTrace* trace = nullptr)
+        : deadline_(deadline), cancelled_(std::move(cancelled)), previous_(current_),
+          trace_(trace || !current_ ? trace : current_->trace_) {
+        current_ = this;
+    }
+
+    ~requestScope() {
+        current_ = previous_;
+    }
+
+    requestScope(const requestScope&) = delete;
+    requestScope& operator=(const requestScope&) = delete;
+
+    // 当前线程上生效的作用域，不在任何请求内时返回 nullptr
+    static const requestScope* current() {
+        return current_;
+    }
+
+    bool hasDeadline() const {
+        return deadline_ != Clock::time_point::max();
+    }
+
+    Clock::time_point deadline() const {
+        return deadline_;
+    }
+
+    // 距截止时间的剩余时长，已过期时为 0
+    std::chrono::milliseconds remaining() const {
+        auto left = deadline_ - Clock::now();
+        return left.count() > 0 ? std::chrono::duration_cast<std::chrono::milliseconds>(left)
+                                : std::chrono::milliseconds(0);
+    }
+
+    bool expired() const {
+        return hasDeadline() && Clock::now() >= deadline_;
+    }
+
+    bool cancelled() const {
+        return cancelled_ && cancelled_();
+    }
+
+    // 客户端已取消或已超时，继续执行的结果不会再被使用
+    bool aborted() const {
+        return expired() || cancelled();
+    }
+
+    // 本请求与 MySQL 之间的往返次数（语句执行、prepare、事务控制、ping），由数据库层累计
+    uint64_t roundTrips() const {
+        return round_trips_;
+    }
+
+    // 当前线程上生效的作用域计一次往返，不在请求内时忽略
+    static void noteRoundTrip() {
+        if (current_) {
+            ++current_->round_trips_;
+        }
+    }
+
+    // 数据库层因熔断拒绝了本请求，RPC 层据此以 UNAVAILABLE 结束
+    bool unavailable() const {
+        return unavailable_;
+    }
+
+    static void noteUnavailable() {
+        if (current_) {
+            current_->unavailable_ = true;
+        }
+    }
+
+    // 当前线程上生效的追踪上下文，不在请求内或请求未追踪时返回 nullptr
+    static requestTrace* trace() {
+        return current_ ? current_->trace_ : nullptr;
+    }
+
+    static void notePhase(TracePhase phase, Clock::time_point start, Clock::time_point end) {
+        if (requestTrace* trace = requestScope::trace()) {
+            trace->record(phase, start, end);
+        }
+    }
+
+    static void noteSql(std::string_view sql) {
+        if (requestTrace* trace = requestScope::trace()) {
+            trace->noteSql(sql);
+        }
+    }
+
+private:
+    Clock::time_point deadline_;
+    std::function<bool()> cancelled_;
+    const requestScope* previous_;
+    requestTrace* trace_;
+    mutable uint64_t round_trips_ = 0;
+    mutable bool unavailable_ = false;
+    static thread_local const requestScope* current_;
+};
+
+inline thread_local const requestScope* requestScope::current_ = nullptr;
+
+// 把所在代码块的耗时记为当前请求的一个阶段（异常退出时同样记录）；请求未追踪时不读时钟
+class phaseTimer {
+public:
+    explicit phaseTimer(TracePhase phase) : trace_(requestScope::trace()), phase_(phase) {
+        if (trace_) {
+            start_ = requestScope::Clock::now();
+        }
+    }
+
+    ~phaseTimer() {
+        if (trace_) {
+            trace_->record(phase_, start_, requestScope::Clock::now());
+        }
+    }
+
+    phaseTimer(const phaseTimer&) = delete;
+    phaseTimer& operator=(const phaseTimer&) = delete;
+
+private:
+    requestTrace* trace_;
+    TracePhase phase_;
+    requestScope::Clock::time_point start_;
+};
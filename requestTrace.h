@@ -0,0 +1,140 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 请求在服务端经历的阶段：Queue 为收到请求到开始执行（含执行器排队），Acquire 为借连接，
+// Prepare 为服务端 prepare（语句缓存未命中时），Execute 为语句执行（含 START TRANSACTION 与会话超时设置），
+// Commit 为 COMMIT/ROLLBACK，Response 为数据库操作结束到发出应答
+enum class TracePhase : uint8_t { Queue, Acquire, Prepare, Execute, Commit, Response, Count };
+
+// 单个请求的追踪上下文：以收到请求的时刻为原点，按单调时钟记录各阶段的起止时间与累计耗时，
+// 以及请求执行过的 SQL。定长、不分配内存，可以放在栈上或请求所在的 arena 上；
+// 由 RPC 入口创建，经 requestScope 交给数据库层记录，请求结束时交给 slowLog 决定是否落盘
+class requestTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int PHASE_COUNT = static_cast<int>(TracePhase::Count);
+    static constexpr int MAX_SPANS = 16;        // 超出后只累计各阶段总耗时
+    static constexpr std::size_t MAX_SQL = 256; // 超出部分截断
+
+    struct Span {
+        TracePhase phase;
+        int64_t start_ns;     // 相对收到请求的时刻
+        int64_t duration_ns;
+    };
+
+    explicit requestTrace(Clock::time_point received) : received_(received) {}
+
+    Clock::time_point received() const {
+        return received_;
+    }
+
+    // 开始执行数据库操作，此前的时间计为 Queue
+    void started(Clock::time_point now = Clock::now()) {
+        record(TracePhase::Queue, received_, now);
+    }
+
+    // 数据库操作结束，之后到 finish 的时间计为 Response
+    void executed(uint64_t round_trips, Clock::time_point now = Clock::now()) {
+        round_trips_ = round_trips;
+        executed_ = now;
+    }
+
+    void finish(Clock::time_point now) {
+        if (executed_ != Clock::time_point()) {
+            record(TracePhase::Response, executed_, now);
+        }
+        finished_ = now;
+    }
+
+    void record(TracePhase phase, Clock::time_point start, Clock::time_point end) {
+        int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        totals_[static_cast<int>(phase)] += duration;
+        if (span_count_ < MAX_SPANS) {
+            int64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - received_).count();
+            spans_[span_count_++] = Span{phase, offset, duration};
+        }
+    }
+
+    // 记录一条 SQL，多条以 "; " 分隔；与上一条相同的语句（如批量写入中的同类操作）只记一次
+    void noteSql(std::string_view sql) {
+        ++statements_;
+        if (sql_truncated_ || 
+            (statements_ > 1 && sql == std::string_view(sql_ + last_sql_, sql_len_ - last_sql_))) {
+            return;
+        }
+        if (sql_len_ > 0) {
+            append("; ", 2);
+        }
+        last_sql_ = sql_len_;
+        append(sql.data(), sql.size());
+    }
+
+    Clock::duration total() const {
+        return finished_ - received_;
+    }
+
+    int64_t phaseNs(TracePhase phase) const {
+        return totals_[static_cast<int>(phase)];
+    }
+
+    const Span* spans() const {
+        return spans_;
+    }
+
+    int spanCount() const {
+        return span_count_;
+    }
+
+    std::string_view sql() const {
+        return std::string_view(sql_, sql_len_);
+    }
+
+    bool sqlTruncated() const {
+        return sql_truncated_;
+    }
+
+    uint32_t statements() const {
+        return statements_;
+    }
+
+    uint64_t roundTrips() const {
+        return round_trips_;
+    }
+
+    static const char* phaseName(TracePhase phase) {
+        static const char* names[PHASE_COUNT] = {"queue", "acquire", "prepare", "execute", "commit", "response"};
+        return names[static_cast<int>(phase)];
+    }
+
+private:
+    // 截断到完整的 UTF-8 字符边界
+    void append(const char* data, std::size_t len) {
+        std::size_t room = MAX_SQL - sql_len_;
+        if (len > room) {
+            len = room;
+            while (len > 0 && (static_cast<unsigned char>(data[len]) & 0xC0) == 0x80) {
+                --len;
+            }
+            sql_truncated_ = true;
+        }
+        std::memcpy(sql_ + sql_len_, data, len);
+        sql_len_ += len;
+    }
+
+    Clock::time_point received_;
+    Clock::time_point executed_;
+    Clock::time_point finished_;
+    int64_t totals_[PHASE_COUNT] = {};
+    Span spans_[MAX_SPANS];
+    int span_count_ = 0;
+    uint32_t statements_ = 0;
+    uint64_t round_trips_ = 0;
+    std::size_t last_sql_ = 0;  // 上一条 SQL 在 sql_ 中的起始位置
+    std::size_t sql_len_ = 0;
+    bool sql_truncated_ = false;
+    char sql_[MAX_SQL];
+};
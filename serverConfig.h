@@ -0,0 +1,234 @@
+#pragma once
+#include "mysqlMgr.h"
+#include "groupCommit.h"
+#include "writeBehind.h"
+#include "bulkImport.h"
+#include "userCache.h"
+#include "asyncLogger.h"
+#include "slowLog.h"
+#include "concurrencyLimiter.h"
+#include <boost/property_tree/ptree.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// [grpc] 部分
+struct GrpcOptions {
+    std::string host;
+    int port = 0;
+    std::string mode = "async";       // mode: async（回调 API + 执行器）或 sync
+    int executor_threads = 0;         // executor_threads: 0 表示与连接池上限相同
+    int executor_queue_size = 4096;
+    int query_page_size = 500;        // query_page_size: 流式查询每页从 MySQL 读取的行数
+};
+
+// [metrics] 部分
+struct MetricsOptions {
+    int prometheus_port = 0;
+    std::string prometheus_host = "0.0.0.0";
+};
+
+// config.ini 解析后的全部配置：加载时解析一次，之后只读；
+// 热加载时解析出新的实例整体替换，读取方始终看到一份完整一致的配置
+struct ServerConfig {
+    GrpcOptions grpc;
+    MysqlConfig mysql;
+    bool group_commit_enabled = false;
+    GroupCommitOptions group_commit;
+    bool write_behind_enabled = false;
+    WriteBehindOptions write_behind;
+    ImportOptions import;
+    bool cache_enabled = true;
+    CacheOptions cache;
+    LogOptions log;
+    TraceOptions trace;
+    MetricsOptions metrics;
+    bool limiter_enabled = true;
+    LimiterOptions limiter;
+
+    // 解析并校验，缺少必需项或取值无效时抛出 std::runtime_error
+    static ServerConfig parse(const boost::property_tree::ptree& pt) {
+        ServerConfig config;
+        reader in(pt);
+
+        config.grpc.host = in.required("grpc", "host");
+        config.grpc.port = in.port("grpc", "port");
+        config.grpc.mode = in.get("grpc", "mode", config.grpc.mode);
+        config.grpc.executor_threads = in.getInt("grpc", "executor_threads", config.grpc.executor_threads);
+        config.grpc.executor_queue_size = in.getInt("grpc", "executor_queue_size", config.grpc.executor_queue_size);
+        config.grpc.query_page_size = std::max(1, in.getInt("grpc", "query_page_size", config.grpc.query_page_size));
+
+        MysqlEndpoint& primary = config.mysql.primary;
+        primary.name = "mysql";
+        primary.host = in.required("mysql", "host");
+        primary.port = std::to_string(in.port("mysql", "port"));
+        primary.user = in.required("mysql", "user");
+        primary.password = in.required("mysql", "password");
+        primary.database = in.required("mysql", "database");
+        primary.pool = readPool(in, "mysql", PoolOptions());
+
+        // 只读副本：[mysql_replica_1]、[mysql_replica_2] ... 依次读取，直到某个编号不存在；
+        // 未配置的项沿用 [mysql] 的值
+        for (int i = 1; pt.find("mysql_replica_" + std::to_string(i)) != pt.not_found(); ++i) {
+            std::string section = "mysql_replica_" + std::to_string(i);
+            MysqlEndpoint replica;
+            replica.host = in.required(section, "host");
+            replica.port = in.get(section, "port", primary.port);
+            replica.user = in.get(section, "user", primary.user);
+            replica.password = in.get(section, "password", primary.password);
+            replica.database = in.get(section, "database", primary.database);
+            replica.pool = readPool(in, section, primary.pool);
+            replica.name = section + "(" + replica.host + ":" + replica.port + ")";
+            config.mysql.replicas.push_back(std::move(replica));
+        }
+
+        ReplicaOptions& replica = config.mysql.replica;
+        replica.health_interval_ms = in.getInt("replica", "health_interval_ms", replica.health_interval_ms);
+        replica.eject_after_failures = in.getInt("replica", "eject_after_failures", replica.eject_after_failures);
+        replica.readmit_after_successes = in.getInt("replica", "readmit_after_successes", replica.readmit_after_successes);
+        replica.max_lag_ms = in.getInt("replica", "max_lag_ms", replica.max_lag_ms);
+
+        BreakerOptions& breaker = config.mysql.breaker;
+        breaker.enabled = in.getInt("breaker", "enabled", 1) != 0;
+        breaker.window_ms = in.getInt("breaker", "window_ms", breaker.window_ms);
+        breaker.min_requests = in.getInt("breaker", "min_requests", breaker.min_requests);
+        breaker.failure_ratio = in.getDouble("breaker", "failure_ratio", breaker.failure_ratio);
+        breaker.consecutive_failures = in.getInt("breaker", "consecutive_failures", breaker.consecutive_failures);
+        breaker.open_ms = in.getInt("breaker", "open_ms", breaker.open_ms);
+        breaker.max_open_ms = in.getInt("breaker", "max_open_ms", breaker.max_open_ms);
+        breaker.half_open_requests = in.getInt("breaker", "half_open_requests", breaker.half_open_requests);
+
+        config.group_commit_enabled = in.getInt("group_commit", "enabled", 0) != 0;
+        GroupCommitOptions& group_commit = config.group_commit;
+        group_commit.window_us = in.getInt("group_commit", "window_us", group_commit.window_us);
+        group_commit.max_batch = in.getInt("group_commit", "max_batch", group_commit.max_batch);
+        group_commit.flushers = in.getInt("group_commit", "flushers", group_commit.flushers);
+        group_commit.max_pending = in.getInt("group_commit", "max_pending", group_commit.max_pending);
+
+        config.write_behind_enabled = in.getInt("write_behind", "enabled", 0) != 0;
+        WriteBehindOptions& write_behind = config.write_behind;
+        write_behind.dir = in.get("write_behind", "dir", write_behind.dir);
+        write_behind.segment_mb = in.getInt("write_behind", "segment_mb", write_behind.segment_mb);
+        write_behind.max_log_mb = in.getInt("write_behind", "max_log_mb", write_behind.max_log_mb);
+        write_behind.sync_window_us = in.getInt("write_behind", "sync_window_us", write_behind.sync_window_us);
+        write_behind.max_batch = in.getInt("write_behind", "max_batch", write_behind.max_batch);
+        write_behind.backpressure_wait_ms = in.getInt("write_behind", "backpressure_wait_ms", 
+                                                      write_behind.backpressure_wait_ms);
+
+        ImportOptions& import = config.import;
+        import.chunk_rows = in.getInt("import", "chunk_rows", import.chunk_rows);
+        import.loaders = in.getInt("import", "loaders", import.loaders);
+        import.max_inflight_chunks = in.getInt("import", "max_inflight_chunks", import.max_inflight_chunks);
+        import.max_errors = in.getInt("import", "max_errors", import.max_errors);
+
+        config.cache_enabled = in.getInt("cache", "enabled", 1) != 0;
+        CacheOptions& cache = config.cache;
+        cache.capacity = in.getInt("cache", "capacity", cache.capacity);
+        cache.ttl_sec = in.getInt("cache", "ttl_sec", cache.ttl_sec);
+        cache.shards = in.getInt("cache", "shards", cache.shards);
+        if (!config.mysql.replicas.empty()) {
+            cache.stale_window_ms = replica.max_lag_ms;
+        }
+
+        LogOptions& log = config.log;
+        log.file = in.get("log", "file", log.file);
+        log.format = in.get("log", "format", log.format);
+        log.level = in.get("log", "level", log.level);
+        log.sample_rate = in.getDouble("log", "sample_rate", log.sample_rate);
+        log.max_file_mb = in.getInt("log", "max_file_mb", log.max_file_mb);
+        log.max_files = in.getInt("log", "max_files", log.max_files);
+        log.flush_interval_ms = in.getInt("log", "flush_interval_ms", log.flush_interval_ms);
+        log.ring_size = in.getInt("log", "ring_size", log.ring_size);
+
+        TraceOptions& trace = config.trace;
+        trace.enabled = in.getInt("trace", "enabled", 1) != 0;
+        trace.slow_ms = in.getInt("trace", "slow_ms", trace.slow_ms);
+        trace.sample_rate = in.getDouble("trace", "sample_rate", trace.sample_rate);
+        trace.file = in.get("trace", "file", trace.file);
+        trace.chrome_trace_file = in.get("trace", "chrome_trace_file", trace.chrome_trace_file);
+        trace.max_file_mb = in.getInt("trace", "max_file_mb", trace.max_file_mb);
+        trace.queue_size = in.getInt("trace", "queue_size", trace.queue_size);
+        trace.flush_interval_ms = in.getInt("trace", "flush_interval_ms", trace.flush_interval_ms);
+
+        config.metrics.prometheus_port = in.getInt("metrics", "prometheus_port", config.metrics.prometheus_port);
+        config.metrics.prometheus_host = in.get("metrics", "prometheus_host", config.metrics.prometheus_host);
+
+        config.limiter_enabled = in.getInt("limiter", "enabled", 1) != 0;
+        LimiterOptions& limiter = config.limiter;
+        limiter.initial_limit = in.getInt("limiter", "initial_limit",
+            2 * std::max(primary.pool.min_conn_num, primary.pool.max_conn_num));
+        limiter.min_limit = in.getInt("limiter", "min_limit", limiter.min_limit);
+        limiter.max_limit = in.getInt("limiter", "max_limit", limiter.max_limit);
+        limiter.tolerance = in.getDouble("limiter", "tolerance", limiter.tolerance);
+        limiter.backoff_ratio = in.getDouble("limiter", "backoff_ratio", limiter.backoff_ratio);
+        limiter.long_window = in.getInt("limiter", "long_window", limiter.long_window);
+        return config;
+    }
+
+private:
+    // 按 "section.key" 读取 ptree，错误信息带上配置项名称
+    class reader {
+    public:
+        explicit reader(const boost::property_tree::ptree& pt) : pt_(pt) {}
+
+        std::string get(const std::string& section, const std::string& key,
+                        const std::string& default_value) const {
+            return pt_.get<std::string>(path(section, key), default_value);
+        }
+
+        std::string required(const std::string& section, const std::string& key) const {
+            std::string value = get(section, key, "");
+            if (value.empty()) {
+                throw std::runtime_error(section + " 部分缺少必需的配置项: " + key);
+            }
+            return value;
+        }
+
+        int getInt(const std::string& section, const std::string& key, int default_value) const {
+            try {
+                return pt_.get<int>(path(section, key), default_value);
+            } catch (const boost::property_tree::ptree_bad_data&) {
+                throw std::runtime_error("配置项不是有效的数字: " + section + "." + key);
+            }
+        }
+
+        double getDouble(const std::string& section, const std::string& key, double default_value) const {
+            try {
+                return pt_.get<double>(path(section, key), default_value);
+            } catch (const boost::property_tree::ptree_bad_data&) {
+                throw std::runtime_error("配置项不是有效的数字: " + section + "." + key);
+            }
+        }
+
+        int port(const std::string& section, const std::string& key) const {
+            required(section, key);
+            int value = getInt(section, key, 0);
+            if (value <= 0 || value > 65535) {
+                throw std::runtime_error("端口号必须在 1-65535 范围内: " + section + "." + key);
+            }
+            return value;
+        }
+
+    private:
+        static boost::property_tree::ptree::path_type path(const std::string& section, const std::string& key) {
+            return boost::property_tree::ptree::path_type(section + "." + key, '.');
+        }
+
+        const boost::property_tree::ptree& pt_;
+    };
+
+    static PoolOptions readPool(const reader& in, const std::string& section, const PoolOptions& defaults) {
+        PoolOptions options = defaults;
+        options.min_conn_num = in.getInt(section, "pool_min_size", options.min_conn_num);
+        options.max_conn_num = in.getInt(section, "pool_max_size", options.max_conn_num);
+        options.acquire_timeout_ms = in.getInt(section, "acquire_timeout_ms", options.acquire_timeout_ms);
+        options.idle_timeout_sec = in.getInt(section, "idle_timeout_sec", options.idle_timeout_sec);
+        options.stmt_cache_size = in.getInt(section, "stmt_cache_size", options.stmt_cache_size);
+        options.keepalive_interval_sec = in.getInt(section, "keepalive_interval_sec", options.keepalive_interval_sec);
+        options.validate_idle_sec = in.getInt(section, "validate_idle_sec", options.validate_idle_sec);
+        options.shards = in.getInt(section, "pool_shards", options.shards);
+        options.warmup_threads = in.getInt(section, "pool_warmup_threads", options.warmup_threads);
+        options.ready_min = in.getInt(section, "pool_ready_min", options.ready_min);
+        return options;
+    }
+};
@@ -0,0 +1,389 @@
+#pragma once
+#include "dbMetrics.h"
+#include "requestTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 请求追踪参数，对应 config.ini 的 [trace] 部分
+struct TraceOptions {
+    bool enabled = true;              // enabled: 0 关闭，请求不再携带追踪上下文
+    int slow_ms = 500;                // slow_ms: 端到端耗时不低于该值的请求写入慢请求日志，0 表示不按耗时记录
+    double sample_rate = 0.0;         // sample_rate: 其余请求按该比例抽样写入
+    std::string file = "slow_requests.log";  // file: 慢请求日志，每行一个 JSON 对象
+    std::string chrome_trace_file;    // chrome_trace_file: 非空时同时写入 Chrome trace 事件（JSON 数组格式）
+    int max_file_mb = 64;             // max_file_mb: 两个文件各自的大小上限，超过后轮转为 .1
+    int queue_size = 1024;            // queue_size: 等待写盘的记录数上限，写满时丢弃并计数，只在启动时生效
+    int flush_interval_ms = 200;      // flush_interval_ms: 后台线程批量写盘的周期
+};
+
+// 慢请求日志：请求结束时按耗时阈值或抽样比例决定是否记录，记录时把定长的追踪上下文
+// 拷贝进预分配的队列，格式化与写盘由后台线程完成。每条记录包含各阶段耗时、阶段时间线、
+// 往返次数与执行过的 SQL；可选地同时输出 Chrome trace 事件，用 chrome://tracing 或 Perfetto 打开，
+// 每个请求占一行，各阶段按时间排开
+class slowLog {
+public:
+    static slowLog& getInstance() {
+        static slowLog instance;
+        return instance;
+    }
+
+    // 启动时调用，运行中可再次调用以热加载：开关、阈值与抽样比例立即生效，
+    // 文件路径与轮转参数由后台线程在下一个写盘周期切换
+    void configure(const TraceOptions& options) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool reopen = options.file != options_.file || options.chrome_trace_file != options_.chrome_trace_file;
+        options_ = options;
+        enabled_.store(options.enabled, std::memory_order_relaxed);
+        slow_ns_.store(static_cast<int64_t>(std::max(0, options.slow_ms)) * 1000000, std::memory_order_relaxed);
+        double rate = std::min(1.0, std::max(0.0, options.sample_rate));
+        sample_threshold_.store(static_cast<uint64_t>(rate * 4294967296.0), std::memory_order_relaxed);
+
+        if (writer_.joinable()) {
+            reopen_ = reopen_ || reopen;
+            return;
+        }
+        if (!options.enabled) {
+            return;
+        }
+        // 后台线程启动前由调用方打开文件，之后文件只由后台线程访问
+        queue_.resize(static_cast<std::size_t>(std::max(1, options.queue_size)), Record{});
+        active_ = options_;
+        openFiles();
+        writer_ = std::thread([this]() { writerLoop(); });
+    }
+
+    // 为 false 时 RPC 入口不再把追踪上下文交给数据库层
+    bool enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // 请求结束（trace.finish 之后）调用：超过阈值或被抽中时入队，否则直接返回
+    void submit(RpcOp op, int status_code, const requestTrace& trace) {
+        if (!enabled()) {
+            return;
+        }
+        int64_t total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(trace.total()).count();
+        int64_t slow_ns = slow_ns_.load(std::memory_order_relaxed);
+        bool slow = slow_ns > 0 && total_ns >= slow_ns;
+        if (!slow && !sampled()) {
+            return;
+        }
+        int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() - total_ns;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty() || count_ == queue_.size()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queue_[(head_ + count_) % queue_.size()] = Record{op, status_code, slow, ++next_id_, wall_ns, trace};
+        ++count_;
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 已记录（入队）的请求数
+    uint64_t recorded() const {
+        return recorded_.load(std::memory_order_relaxed);
+    }
+
+    // 队列已满而丢弃的记录数
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    ~slowLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        closeFile(log_);
+        closeFile(chrome_);
+    }
+
+private:
+    struct Record {
+        RpcOp op = RpcOp::Count;
+        int status_code = 0;
+        bool slow = false;
+        uint64_t id = 0;
+        int64_t wall_ns = 0;  // 收到请求时的系统时间
+        requestTrace trace{requestTrace::Clock::time_point()};
+    };
+
+    struct File {
+        std::FILE* handle = nullptr;
+        long size = 0;
+    };
+
+    slowLog() = default;
+
+    bool sampled() {
+        uint64_t threshold = sample_threshold_.load(std::memory_order_relaxed);
+        if (threshold == 0) {
+            return false;
+        }
+        thread_local uint64_t state =
+            reinterpret_cast<uintptr_t>(&state) ^ 0x9e3779b97f4a7c15ULL;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (state & 0xffffffffULL) < threshold;
+    }
+
+    static void closeFile(File& file) {
+        if (file.handle) {
+            std::fclose(file.handle);
+            file.handle = nullptr;
+        }
+    }
+
+    // Chrome trace 文件以 "[" 开头，之后每个事件占一行并以 "," 结尾；
+    // 该格式允许省略结尾的 "]"，进程随时退出文件都能直接打开
+    static bool openFile(File& file, const std::string& path, bool chrome) {
+        closeFile(file);
+        if (path.empty()) {
+            return true;
+        }
+        file.handle = std::fopen(path.c_str(), "a");
+        if (!file.handle) {
+            std::cerr << "慢请求日志文件打开失败: " << path << std::endl;
+            return false;
+        }
+        std::fseek(file.handle, 0, SEEK_END);
+        file.size = std::ftell(file.handle);
+        if (chrome && file.size == 0) {
+            std::fputs("[\n", file.handle);
+            file.size = 2;
+        }
+        return true;
+    }
+
+    void openFiles() {
+        openFile(log_, active_.file, false);
+        openFile(chrome_, active_.chrome_trace_file, true);
+    }
+
+    void write(File& file, const std::string& path, bool chrome, const std::string& buffer) {
+        if (buffer.empty() || !file.handle) {
+            return;
+        }
+        std::fwrite(buffer.data(), 1, buffer.size(), file.handle);
+        std::fflush(file.handle);
+        file.size += static_cast<long>(buffer.size());
+        if (active_.max_file_mb > 0 && file.size >= static_cast<long>(active_.max_file_mb) * 1024 * 1024) {
+            closeFile(file);
+            std::rename(path.c_str(), (path + ".1").c_str());
+            openFile(file, path, chrome);
+        }
+    }
+
+    void writerLoop() {
+        std::vector<Record> batch;
+        batch.reserve(queue_.size());
+        std::string log_buffer;
+        std::string chrome_buffer;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait_for(lock, std::chrono::milliseconds(std::max(1, active_.flush_interval_ms)),
+                           [this]() { return stop_; });
+            bool stopping = stop_;
+            for (; count_ > 0; --count_) {
+                batch.push_back(queue_[head_]);
+                head_ = (head_ + 1) % queue_.size();
+            }
+            // 取走热加载的新参数，之后的格式化与写盘只读 active_
+            active_ = options_;
+            bool reopen = reopen_;
+            reopen_ = false;
+            lock.unlock();
+
+            if (reopen) {
+                openFiles();
+            }
+            for (const Record& record : batch) {
+                formatLog(record, log_buffer);
+                if (chrome_.handle) {
+                    formatChrome(record, chrome_buffer);
+                }
+            }
+            write(log_, active_.file, false, log_buffer);
+            write(chrome_, active_.chrome_trace_file, true, chrome_buffer);
+            batch.clear();
+            log_buffer.clear();
+            chrome_buffer.clear();
+
+            if (stopping) {
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    static void appendEscaped(std::string& buffer, std::string_view text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                buffer += '\\';
+                buffer += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer += escaped;
+            } else {
+                buffer += c;
+            }
+        }
+    }
+
+    // 纳秒值按微秒输出，保留 3 位小数
+    static void appendMicros(std::string& buffer, int64_t ns) {
+        char text[32];
+        if (ns < 0) {
+            ns = 0;
+        }
+        std::snprintf(text, sizeof(text), "%lld.%03lld", static_cast<long long>(ns / 1000),
+                      static_cast<long long>(ns % 1000));
+        buffer += text;
+    }
+
+    static void formatLog(const Record& record, std::string& buffer) {
+        const requestTrace& trace = record.trace;
+        int64_t total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(trace.total()).count();
+
+        std::time_t seconds = static_cast<std::time_t>(record.wall_ns / 1000000000);
+        std::tm tm_utc;
+        gmtime_r(&seconds, &tm_utc);
+        char ts[40];
+        std::size_t ts_len = std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm_utc);
+        std::snprintf(ts + ts_len, sizeof(ts) - ts_len, ".%06dZ",
+                      static_cast<int>(record.wall_ns / 1000 % 1000000));
+
+        buffer += "{\"ts\":\"";
+        buffer += ts;
+        buffer += "\",\"trace_id\":";
+        buffer += std::to_string(record.id);
+        buffer += ",\"op\":\"";
+        buffer += dbMetrics::opName(record.op);
+        buffer += "\",\"code\":\"";
+        buffer += dbMetrics::statusName(record.status_code);
+        buffer += "\",\"reason\":\"";
+        buffer += record.slow ? "slow" : "sampled";
+        buffer += "\",\"total_us\":";
+        appendMicros(buffer, total_ns);
+
+        // 各阶段累计耗时；other 为不属于任何阶段的时间（如缓存、日志、流式查询写给客户端）
+        buffer += ",\"phases_us\":{";
+        int64_t accounted = 0;
+        for (int phase = 0; phase < requestTrace::PHASE_COUNT; ++phase) {
+            int64_t ns = trace.phaseNs(static_cast<TracePhase>(phase));
+            accounted += ns;
+            buffer += '"';
+            buffer += requestTrace::phaseName(static_cast<TracePhase>(phase));
+            buffer += "\":";
+            appendMicros(buffer, ns);
+            buffer += ',';
+        }
+        buffer += "\"other\":";
+        appendMicros(buffer, total_ns - accounted);
+        buffer += "},\"round_trips\":";
+        buffer += std::to_string(trace.roundTrips());
+        buffer += ",\"statements\":";
+        buffer += std::to_string(trace.statements());
+
+        // 时间线：各阶段相对收到请求时刻的起点与耗时
+        buffer += ",\"spans\":[";
+        for (int i = 0; i < trace.spanCount(); ++i) {
+            const requestTrace::Span& span = trace.spans()[i];
+            buffer += i == 0 ? "{\"phase\":\"" : ",{\"phase\":\"";
+            buffer += requestTrace::phaseName(span.phase);
+            buffer += "\",\"start_us\":";
+            appendMicros(buffer, span.start_ns);
+            buffer += ",\"dur_us\":";
+            appendMicros(buffer, span.duration_ns);
+            buffer += '}';
+        }
+        buffer += "],\"sql\":\"";
+        appendEscaped(buffer, trace.sql());
+        buffer += trace.sqlTruncated() ? "\",\"sql_truncated\":true}\n" : "\"}\n";
+    }
+
+    // 每个请求一个线程轨道（tid 为 trace_id）：一个覆盖整个请求的事件，其下为各阶段
+    static void formatChrome(const Record& record, std::string& buffer) {
+        const requestTrace& trace = record.trace;
+        std::string tid = std::to_string(record.id);
+        const char* op = dbMetrics::opName(record.op);
+
+        buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        buffer += tid;
+        buffer += ",\"args\":{\"name\":\"";
+        buffer += op;
+        buffer += " #";
+        buffer += tid;
+        buffer += "\"}},\n";
+
+        buffer += "{\"name\":\"";
+        buffer += op;
+        buffer += "\",\"cat\":\"rpc\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+        buffer += tid;
+        buffer += ",\"ts\":";
+        appendMicros(buffer, record.wall_ns);
+        buffer += ",\"dur\":";
+        appendMicros(buffer, std::chrono::duration_cast<std::chrono::nanoseconds>(trace.total()).count());
+        buffer += ",\"args\":{\"code\":\"";
+        buffer += dbMetrics::statusName(record.status_code);
+        buffer += "\",\"round_trips\":";
+        buffer += std::to_string(trace.roundTrips());
+        buffer += ",\"sql\":\"";
+        appendEscaped(buffer, trace.sql());
+        buffer += "\"}},\n";
+
+        for (int i = 0; i < trace.spanCount(); ++i) {
+            const requestTrace::Span& span = trace.spans()[i];
+            buffer += "{\"name\":\"";
+            buffer += requestTrace::phaseName(span.phase);
+            buffer += "\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            buffer += tid;
+            buffer += ",\"ts\":";
+            appendMicros(buffer, record.wall_ns + span.start_ns);
+            buffer += ",\"dur\":";
+            appendMicros(buffer, span.duration_ns);
+            buffer += "},\n";
+        }
+    }
+
+    TraceOptions options_;   // 最近一次 configure 的参数，受 mutex_ 保护
+    TraceOptions active_;    // 后台线程正在使用的参数，只由后台线程读写
+    bool reopen_ = false;    // 文件路径已变更，后台线程需重新打开
+    std::atomic<bool> enabled_{false};
+    std::atomic<int64_t> slow_ns_{0};
+    std::atomic<uint64_t> sample_threshold_{0};
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // 预分配的环形队列，受 mutex_ 保护
+    std::vector<Record> queue_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    uint64_t next_id_ = 0;
+
+    File log_;
+    File chrome_;
+
+    bool stop_ = false;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread writer_;
+};
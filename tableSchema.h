@@ -0,0 +1,333 @@
+#pragma once
+#include "mysqlDao.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// 编译期的表结构描述：列名、列类型与键列。
+// 增删改查的 SQL 文本在编译期拼好（tableSql），参数绑定与结果解码按列类型静态分派、按列序号读取，
+// 新增一张表只需一行类型定义，运行时不再拼接 SQL，也不按列名查找结果列
+
+// 列类型到 Connector/C++ 调用的映射：param 为绑定参数时接受的类型
+template <typename T>
+struct sqlType;
+
+template <>
+struct sqlType<std::string> {
+    using param = std::string_view;
+    static void bind(sql::PreparedStatement* pstmt, unsigned int index, std::string_view value) {
+        bindString(pstmt, index, value);
+    }
+    static std::string read(sql::ResultSet* rs, unsigned int index) {
+        return rs->getString(index);
+    }
+};
+
+template <>
+struct sqlType<int> {
+    using param = int;
+    static void bind(sql::PreparedStatement* pstmt, unsigned int index, int value) {
+        pstmt->setInt(index, value);
+    }
+    static int read(sql::ResultSet* rs, unsigned int index) {
+        return rs->getInt(index);
+    }
+};
+
+template <>
+struct sqlType<int64_t> {
+    using param = int64_t;
+    static void bind(sql::PreparedStatement* pstmt, unsigned int index, int64_t value) {
+        pstmt->setInt64(index, value);
+    }
+    static int64_t read(sql::ResultSet* rs, unsigned int index) {
+        return rs->getInt64(index);
+    }
+};
+
+template <>
+struct sqlType<double> {
+    using param = double;
+    static void bind(sql::PreparedStatement* pstmt, unsigned int index, double value) {
+        pstmt->setDouble(index, value);
+    }
+    static double read(sql::ResultSet* rs, unsigned int index) {
+        return static_cast<double>(rs->getDouble(index));
+    }
+};
+
+// 一列：Name 须为具有静态存储期的字符数组（如 inline constexpr char[]），Key 表示该列属于键
+template <const char* Name, typename T, bool Key = false>
+struct schemaColumn {
+    static constexpr const char* name = Name;
+    using type = T;
+    using param = typename sqlType<T>::param;
+    static constexpr bool key = Key;
+};
+
+namespace schemaDetail {
+
+// 编译期拼接 SQL 的两种输出：先用 lengthCounter 量出长度，再写入等长的 fixedSql
+struct lengthCounter {
+    std::size_t size = 0;
+    constexpr void append(const char* s) {
+        while (*s++) {
+            ++size;
+        }
+    }
+};
+
+template <std::size_t N>
+struct fixedSql {
+    char text[N + 1] = {};
+    std::size_t size = 0;
+
+    constexpr void append(const char* s) {
+        while (*s) {
+            text[size++] = *s++;
+        }
+    }
+    constexpr const char* c_str() const {
+        return text;
+    }
+    constexpr std::string_view view() const {
+        return std::string_view(text, size);
+    }
+};
+
+enum class pick { all, keys, values };
+
+struct insertStatement {};       // INSERT INTO t (a, b) VALUES (?, ?)
+struct updateStatement {};       // UPDATE t SET <值列> = ? WHERE <键列> = ?
+struct deleteStatement {};       // DELETE FROM t WHERE <所有列> = ?，按整行匹配
+struct selectByKeyStatement {};  // SELECT <值列> FROM t WHERE <键列> = ? ORDER BY <值列>
+struct selectAllStatement {};    // SELECT <所有列> FROM t，调用方追加条件
+struct orderByAllStatement {};   // ORDER BY <所有列>，键集分页用
+struct insertPrefixStatement {}; // INSERT INTO t (a, b) VALUES ，多行 INSERT 的前缀
+struct rowStatement {};          // (?, ?)，多行 INSERT 中的一行
+
+template <typename Table, typename Statement>
+constexpr std::size_t sqlLength() {
+    lengthCounter counter;
+    Table::build(counter, Statement{});
+    return counter.size;
+}
+
+template <typename Table, typename Statement>
+constexpr fixedSql<sqlLength<Table, Statement>()> compileSql() {
+    fixedSql<sqlLength<Table, Statement>()> sql;
+    Table::build(sql, Statement{});
+    return sql;
+}
+
+}  // namespace schemaDetail
+
+// 表结构：Name 为表名，Columns 为 schemaColumn 列表（至少一个键列与一个值列）
+template <const char* Name, typename... Columns>
+class tableSchema {
+public:
+    static constexpr const char* name = Name;
+    static constexpr std::size_t COLUMNS = sizeof...(Columns);
+    static constexpr std::size_t KEYS = (std::size_t(0) + ... + (Columns::key ? 1 : 0));
+    static_assert(KEYS > 0 && KEYS < COLUMNS, "tableSchema 需要至少一个键列和一个值列");
+
+    using row = std::tuple<typename Columns::type...>;       // 整行
+    using params = std::tuple<typename Columns::param...>;   // 整行参数：INSERT/UPDATE/DELETE
+    using keyParams = decltype(std::tuple_cat(std::declval<
+        std::conditional_t<Columns::key, std::tuple<typename Columns::param>, std::tuple<>>>()...));
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::insertStatement) {
+        build(out, schemaDetail::insertPrefixStatement{});
+        build(out, schemaDetail::rowStatement{});
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::updateStatement) {
+        out.append("UPDATE ");
+        out.append(name);
+        out.append(" SET ");
+        columnList(out, schemaDetail::pick::values, " = ?", ", ");
+        out.append(" WHERE ");
+        columnList(out, schemaDetail::pick::keys, " = ?", " AND ");
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::deleteStatement) {
+        out.append("DELETE FROM ");
+        out.append(name);
+        out.append(" WHERE ");
+        columnList(out, schemaDetail::pick::all, " = ?", " AND ");
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::selectByKeyStatement) {
+        out.append("SELECT ");
+        columnList(out, schemaDetail::pick::values, "", ", ");
+        out.append(" FROM ");
+        out.append(name);
+        out.append(" WHERE ");
+        columnList(out, schemaDetail::pick::keys, " = ?", " AND ");
+        out.append(" ORDER BY ");
+        columnList(out, schemaDetail::pick::values, "", ", ");
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::selectAllStatement) {
+        out.append("SELECT ");
+        columnList(out, schemaDetail::pick::all, "", ", ");
+        out.append(" FROM ");
+        out.append(name);
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::orderByAllStatement) {
+        out.append(" ORDER BY ");
+        columnList(out, schemaDetail::pick::all, "", ", ");
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::insertPrefixStatement) {
+        out.append("INSERT INTO ");
+        out.append(name);
+        out.append(" (");
+        columnList(out, schemaDetail::pick::all, "", ", ");
+        out.append(") VALUES ");
+    }
+
+    template <typename Out>
+    static constexpr void build(Out& out, schemaDetail::rowStatement) {
+        out.append("(");
+        bool first = true;
+        ((appendItem(out, first, ", ", "?", ""), void(sizeof(Columns))), ...);
+        out.append(")");
+    }
+
+    // INSERT 与 DELETE：按列定义顺序绑定整行；多行 INSERT 从 index 起连续绑定，返回下一个参数序号
+    static unsigned int bindRow(sql::PreparedStatement* pstmt, const params& values, unsigned int index = 1) {
+        return bindColumns(pstmt, values, schemaDetail::pick::all, index, std::index_sequence_for<Columns...>{});
+    }
+
+    // UPDATE：先值列，后键列
+    static void bindUpdate(sql::PreparedStatement* pstmt, const params& values) {
+        unsigned int index = bindColumns(pstmt, values, schemaDetail::pick::values, 1,
+                                         std::index_sequence_for<Columns...>{});
+        bindColumns(pstmt, values, schemaDetail::pick::keys, index, std::index_sequence_for<Columns...>{});
+    }
+
+    // SELECT 按键查询：只绑定键列
+    static void bindKey(sql::PreparedStatement* pstmt, const keyParams& key) {
+        bindKeys(pstmt, key, std::index_sequence_for<Columns...>{});
+    }
+
+    // 解码按键查询的一行（值列，从第 1 列起），以列类型的值调用 on_row
+    template <typename Func>
+    static void decodeValues(sql::ResultSet* rs, Func&& on_row) {
+        std::apply(std::forward<Func>(on_row),
+                   readPicked<schemaDetail::pick::values>(rs, std::index_sequence_for<Columns...>{}));
+    }
+
+    // 解码整行（所有列，从第 1 列起），以列类型的值调用 on_row
+    template <typename Func>
+    static void decodeRow(sql::ResultSet* rs, Func&& on_row) {
+        std::apply(std::forward<Func>(on_row),
+                   readPicked<schemaDetail::pick::all>(rs, std::index_sequence_for<Columns...>{}));
+    }
+
+private:
+    using columns = std::tuple<Columns...>;
+
+    template <typename Column>
+    static constexpr bool picked(schemaDetail::pick which) {
+        return which == schemaDetail::pick::all || (which == schemaDetail::pick::keys) == Column::key;
+    }
+
+    // 被选中的列在结果集中的序号（从 1 开始），未选中时为 0
+    template <std::size_t I>
+    static constexpr unsigned int position(schemaDetail::pick which) {
+        constexpr bool flags[] = {Columns::key...};
+        unsigned int pos = 0;
+        for (std::size_t i = 0; i <= I; ++i) {
+            if (which == schemaDetail::pick::all || (which == schemaDetail::pick::keys) == flags[i]) {
+                ++pos;
+            }
+        }
+        return picked<std::tuple_element_t<I, columns>>(which) ? pos : 0;
+    }
+
+    template <typename Out>
+    static constexpr void appendItem(Out& out, bool& first, const char* separator,
+                                     const char* item, const char* suffix) {
+        if (!first) {
+            out.append(separator);
+        }
+        first = false;
+        out.append(item);
+        out.append(suffix);
+    }
+
+    template <typename Out>
+    static constexpr void columnList(Out& out, schemaDetail::pick which, const char* suffix,
+                                     const char* separator) {
+        bool first = true;
+        ((picked<Columns>(which) ? appendItem(out, first, separator, Columns::name, suffix) : void()), ...);
+    }
+
+    template <std::size_t... I>
+    static unsigned int bindColumns(sql::PreparedStatement* pstmt, const params& values,
+                                    schemaDetail::pick which, unsigned int index, std::index_sequence<I...>) {
+        ((picked<Columns>(which)
+              ? sqlType<typename Columns::type>::bind(pstmt, index++, std::get<I>(values))
+              : void()), ...);
+        return index;
+    }
+
+    template <std::size_t... I>
+    static void bindKeys(sql::PreparedStatement* pstmt, const keyParams& key, std::index_sequence<I...>) {
+        (bindKeyColumn<I>(pstmt, key), ...);
+    }
+
+    template <std::size_t I>
+    static void bindKeyColumn(sql::PreparedStatement* pstmt, const keyParams& key) {
+        using Column = std::tuple_element_t<I, columns>;
+        if constexpr (Column::key) {
+            constexpr unsigned int pos = position<I>(schemaDetail::pick::keys);
+            sqlType<typename Column::type>::bind(pstmt, pos, std::get<pos - 1>(key));
+        }
+    }
+
+    // 被选中的列按各自的序号读取；参数求值顺序不影响结果
+    template <schemaDetail::pick Which, std::size_t... I>
+    static auto readPicked(sql::ResultSet* rs, std::index_sequence<I...>) {
+        return std::tuple_cat(readIfPicked<Which, I>(rs)...);
+    }
+
+    template <schemaDetail::pick Which, std::size_t I>
+    static auto readIfPicked(sql::ResultSet* rs) {
+        using Column = std::tuple_element_t<I, columns>;
+        if constexpr (picked<Column>(Which)) {
+            return std::make_tuple(sqlType<typename Column::type>::read(rs, position<I>(Which)));
+        } else {
+            return std::tuple<>();
+        }
+    }
+};
+
+// 由表结构在编译期生成的语句文本
+template <typename Table>
+struct tableSql {
+    static constexpr auto INSERT = schemaDetail::compileSql<Table, schemaDetail::insertStatement>();
+    static constexpr auto UPDATE = schemaDetail::compileSql<Table, schemaDetail::updateStatement>();
+    static constexpr auto DELETE = schemaDetail::compileSql<Table, schemaDetail::deleteStatement>();
+    static constexpr auto SELECT_BY_KEY = schemaDetail::compileSql<Table, schemaDetail::selectByKeyStatement>();
+    static constexpr auto SELECT_ALL = schemaDetail::compileSql<Table, schemaDetail::selectAllStatement>();
+    static constexpr auto ORDER_BY_ALL = schemaDetail::compileSql<Table, schemaDetail::orderByAllStatement>();
+    static constexpr auto INSERT_PREFIX = schemaDetail::compileSql<Table, schemaDetail::insertPrefixStatement>();
+    static constexpr auto ROW = schemaDetail::compileSql<Table, schemaDetail::rowStatement>();
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+// 缓存参数，对应 config.ini 的 [cache] 部分
+struct CacheOptions {
+    int capacity = 100000;  // capacity: 缓存的 name 数上限（所有分片合计）
+    int ttl_sec = 60;       // ttl_sec: 条目最长存活时间，兜底防止漏失效
+    int shards = 16;        // shards: 分片数，降低锁竞争
+    int stale_window_ms = 0;  // 写失效后该时长内拒绝来自只读副本的回填，配置了副本时取 [replica] max_lag_ms
+};
+
+// 按 name 缓存点查结果（该 name 下所有记录的 age）的分片 LRU 缓存
+// 写路径调用 invalidate 使条目失效；为避免“失效之后又被旧数据回填”，
+// 回填使用 get 未命中时取得的票据，期间分片发生过失效则放弃回填
+class userCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t expirations;
+        uint64_t invalidations;
+        uint64_t size;
+    };
+
+    explicit userCache(const CacheOptions& options)
+        : ttl_sec_(std::max(1, options.ttl_sec)),
+          stale_window_(std::chrono::milliseconds(std::max(0, options.stale_window_ms))),
+          shards_(static_cast<std::size_t>(std::max(1, options.shards))) {
+        std::size_t per_shard = static_cast<std::size_t>(std::max(1, options.capacity)) / shards_.size();
+        for (auto& shard : shards_) {
+            shard.capacity = std::max<std::size_t>(1, per_shard);
+        }
+    }
+
+    // 运行中调整容量与 TTL（配置热加载）；容量调小时立即淘汰最久未用的条目，
+    // TTL 只影响之后回填的条目。分片数只在启动时生效
+    void resize(int capacity, int ttl_sec) {
+        ttl_sec_.store(std::max(1, ttl_sec), std::memory_order_relaxed);
+        std::size_t per_shard = std::max<std::size_t>(1, 
+            static_cast<std::size_t>(std::max(1, capacity)) / shards_.size());
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.capacity = per_shard;
+            while (shard.lru.size() > shard.capacity) {
+                shard.index.erase(shard.lru.back().name);
+                shard.lru.pop_back();
+                evictions_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 命中时填充 ages 并返回 true；未命中时返回 false，ticket 用于随后的 putIfFresh
+    bool get(const std::string& name, std::vector<int>& ages, uint64_t& ticket) {
+        Shard& shard = shardFor(name);
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ticket = shard.generation;
+
+        auto it = shard.index.find(name);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (it->second->expires <= now) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        ages = it->second->ages;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 回填数据库读到的结果；ticket 之后该分片若有写失效则丢弃。
+    // 结果来自只读副本时，副本可能尚未应用最近的写入，name 在 stale_window_ms 内被失效过也丢弃
+    void putIfFresh(const std::string& name, std::vector<int> ages, uint64_t ticket, 
+                    bool from_replica = false) {
+        Shard& shard = shardFor(name);
+        auto now = std::chrono::steady_clock::now();
+        auto expires = now + std::chrono::seconds(ttl_sec_.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.generation != ticket) {
+            return;
+        }
+        if (from_replica && stale_window_.count() > 0) {
+            purgeRecent(shard, now);
+            if (shard.recent.count(name) > 0) {
+                return;
+            }
+        }
+
+        auto it = shard.index.find(name);
+        if (it != shard.index.end()) {
+            it->second->ages = std::move(ages);
+            it->second->expires = expires;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+
+        if (shard.lru.size() >= shard.capacity) {
+            shard.index.erase(shard.lru.back().name);
+            shard.lru.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.lru.push_front(Entry{name, std::move(ages), expires});
+        shard.index[name] = shard.lru.begin();
+    }
+
+    // 写路径调用：删除条目并推进分片版本，使进行中的回填失效
+    void invalidate(const std::string& name) {
+        Shard& shard = shardFor(name);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        if (stale_window_.count() > 0) {
+            auto now = std::chrono::steady_clock::now();
+            purgeRecent(shard, now);
+            shard.recent[name] = now + stale_window_;
+            shard.recent_order.emplace_back(now + stale_window_, name);
+        }
+        auto it = shard.index.find(name);
+        if (it != shard.index.end()) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+        }
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Stats stats() {
+        Stats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.expirations = expirations_.load(std::memory_order_relaxed);
+        stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+        stats.size = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.size += shard.lru.size();
+        }
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        std::vector<int> ages;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // 表头为最近使用
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::size_t capacity = 1;
+        uint64_t generation = 0;
+        // 最近被写失效的 name 及其窗口到期时间，recent_order 按到期时间排列用于清理
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> recent;
+        std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> recent_order;
+    };
+
+    static void purgeRecent(Shard& shard, std::chrono::steady_clock::time_point now) {
+        while (!shard.recent_order.empty() && shard.recent_order.front().first <= now) {
+            auto it = shard.recent.find(shard.recent_order.front().second);
+            if (it != shard.recent.end() && it->second <= now) {
+                shard.recent.erase(it);
+            }
+            shard.recent_order.pop_front();
+        }
+    }
+
+    Shard& shardFor(const std::string& name) {
+        return shards_[std::hash<std::string>()(name) % shards_.size()];
+    }
+
+    std::atomic<int> ttl_sec_;
+    const std::chrono::steady_clock::duration stale_window_;
+    std::vector<Shard> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+    std::atomic<uint64_t> invalidations_{0};
+};
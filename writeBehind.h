@@ -0,0 +1,725 @@
+#pragma once
+#include "mysqlMgr.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 延迟写回参数，对应 config.ini 的 [write_behind] 部分
+struct WriteBehindOptions {
+    std::string dir = "wal";          // dir: 日志目录，每个日志段一个文件
+    int segment_mb = 64;              // segment_mb: 单个日志段的大小
+    int max_log_mb = 1024;            // max_log_mb: 未写回 MySQL 的日志上限，写满后写入方等待
+    int sync_window_us = 1000;        // sync_window_us: 首条写入到达后最多等待多久合并 fsync
+    int max_batch = 1000;             // max_batch: 写回 MySQL 时单个事务最多包含的操作数
+    int backpressure_wait_ms = 50;    // backpressure_wait_ms: 日志已满时写入方最多等待多久
+};
+
+// 延迟写回：写操作追加到本地的内存映射日志，合并 fsync 后即向客户端确认，
+// 后台线程按 LSN 顺序把日志以大事务批量写回 MySQL 并记录检查点。
+// 进程崩溃后重启时从检查点之后重放日志；检查点在每批提交后落盘，
+// 提交与落盘之间崩溃时该批会被重放一次（至少一次语义）。
+//
+// 日志段文件 wal-<首条 LSN>.log 预先分配固定大小，记录格式为
+// [负载长度 u32][CRC32C u32][LSN u64][类型 u8][age i32][name]，按 8 字节对齐；
+// 负载长度为 0 表示段内没有更多记录。恢复时遇到第一条校验失败或 LSN 不连续的记录即截断
+class writeBehindLog {
+public:
+    using Callback = std::function<void(bool durable)>;
+    using AppliedCallback = std::function<void(const std::vector<BatchOp>&)>;
+
+    struct Stats {
+        uint64_t backlog;         // 已确认、尚未写回 MySQL 的操作数
+        uint64_t durable_lsn;
+        uint64_t applied_lsn;
+        uint64_t log_bytes;       // 日志段占用的磁盘空间
+        uint64_t rejected;        // 日志已满被拒绝的写入
+        uint64_t apply_failures;  // 写回 MySQL 时被数据库拒绝而丢弃的操作
+        uint64_t apply_retries;   // 整批未能写入 MySQL（数据库不可用、熔断器断开）而推迟重试的次数
+        uint64_t fsyncs;
+        uint64_t sync_failures;   // fsync 失败的次数，每次作废当时未落盘的记录
+    };
+
+    // on_applied 在每批写回提交后于写回线程中调用，用于使缓存失效
+    writeBehindLog(mysqlMgr& mgr, const WriteBehindOptions& options, AppliedCallback on_applied)
+        : mgr_(mgr),
+          on_applied_(std::move(on_applied)),
+          dir_(options.dir.empty() ? std::string(".") : options.dir),
+          segment_size_(static_cast<std::size_t>(std::max(1, options.segment_mb)) << 20),
+          max_segments_(std::max<std::size_t>(2, static_cast<std::size_t>(
+              std::max(1, options.max_log_mb / std::max(1, options.segment_mb))))),
+          sync_window_(std::chrono::microseconds(std::max(0, options.sync_window_us))),
+          max_batch_(static_cast<std::size_t>(std::max(1, options.max_batch))),
+          backpressure_wait_(std::chrono::milliseconds(std::max(0, options.backpressure_wait_ms))) {
+        recover();
+        sync_thread_ = std::thread([this]() { syncLoop(); });
+        apply_thread_ = std::thread([this]() { applyLoop(); });
+        std::cout << "延迟写回已启用: 日志目录 " << dir_ << ", 日志段 " << (segment_size_ >> 20)
+                  << "MB x " << max_segments_ << std::endl;
+    }
+
+    ~writeBehindLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        sync_cond_.notify_all();
+        apply_cond_.notify_all();
+        applied_cond_.notify_all();
+        if (apply_thread_.joinable()) {
+            apply_thread_.join();
+        }
+        if (sync_thread_.joinable()) {
+            sync_thread_.join();
+        }
+        if (checkpoint_fd_ >= 0) {
+            close(checkpoint_fd_);
+        }
+        uint64_t backlog = written_lsn_ - applied_lsn_.load();
+        if (backlog > 0) {
+            std::cout << "延迟写回日志中还有 " << backlog << " 条操作未写回, 下次启动时重放" << std::endl;
+        }
+    }
+
+    writeBehindLog(const writeBehindLog&) = delete;
+    writeBehindLog& operator=(const writeBehindLog&) = delete;
+
+    // 追加一条写操作，done 在日志落盘后于 fsync 线程中调用，durable 为 false 表示落盘失败、该操作已作废；
+    // 日志已满且 backpressure_wait_ms 内没有腾出空间（主库熔断器断开时不等待）时返回 false，done 不会被调用
+    bool submit(const BatchOp& op, Callback done) {
+        std::size_t size = recordSize(op.name.size());
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (size > segment_size_) {
+            std::cerr << "写操作超过日志段大小, 无法写入延迟写回日志" << std::endl;
+            return false;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + backpressure_wait_;
+        while (true) {
+            if (stop_) {
+                return false;
+            }
+            Segment& tail = *segments_.back();
+            if (tail.write_offset + size <= tail.size) {
+                break;
+            }
+            if (segments_.size() < max_segments_) {
+                try {
+                    segments_.push_back(createSegment(next_lsn_));
+                } catch (const std::exception& e) {
+                    std::cerr << "创建日志段失败: " << e.what() << std::endl;
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                continue;
+            }
+            // 写回落后太多：等待写回线程释放日志段，超时即拒绝，由客户端退避重试。
+            // 主库熔断器断开时积压不会减少，不再等待，立即拒绝
+            if (!mgr_.writable()) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (applied_cond_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        Segment& tail = *segments_.back();
+        uint64_t lsn = next_lsn_++;
+        encode(tail.base + tail.write_offset, lsn, op);
+        tail.write_offset += size;
+        tail.last_lsn = lsn;
+        written_lsn_ = lsn;
+        waiters_.push_back(Waiter{lsn, std::move(done)});
+        if (waiters_.size() == 1) {
+            sync_cond_.notify_one();
+        }
+        return true;
+    }
+
+    // 等待启动时发现的未写回操作全部重放完成
+    bool waitReplayed(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return applied_cond_.wait_for(lock, timeout, [this]() {
+            return stop_ || applied_lsn_.load() >= replay_target_;
+        });
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t applied = applied_lsn_.load();
+        return Stats{written_lsn_ - applied, durable_lsn_.load(), applied,
+                     static_cast<uint64_t>(segments_.size() * segment_size_),
+                     rejected_.load(), apply_failures_.load(), apply_retries_.load(), 
+                     fsyncs_.load(), sync_failures_.load()};
+    }
+
+private:
+    struct Segment {
+        uint64_t first_lsn = 0;
+        uint64_t last_lsn = 0;           // 段内最后一条记录的 LSN，空段为 first_lsn - 1
+        std::string path;
+        char* base = nullptr;
+        std::size_t size = 0;
+        std::size_t write_offset = 0;    // 以下两项受 mutex_ 保护
+        std::size_t synced_offset = 0;
+
+        ~Segment() {
+            if (base != nullptr) {
+                munmap(base, size);
+            }
+        }
+    };
+
+    struct Waiter {
+        uint64_t lsn;
+        Callback done;
+    };
+
+    struct Record {
+        uint64_t lsn;
+        std::size_t size;  // 含头部与对齐填充
+        BatchOp op;
+    };
+
+    static const std::size_t HEADER_SIZE = 16;
+    static const std::size_t FIXED_PAYLOAD = 5;  // 类型 + age
+
+    static std::size_t recordSize(std::size_t name_size) {
+        return (HEADER_SIZE + FIXED_PAYLOAD + name_size + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    static uint32_t crc32c(const char* data, std::size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = []() {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? (value >> 1) ^ 0x82F63B78u : value >> 1;
+                }
+                entries[i] = value;
+            }
+            return entries;
+        }();
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    static void encode(char* out, uint64_t lsn, const BatchOp& op) {
+        uint32_t length = static_cast<uint32_t>(FIXED_PAYLOAD + op.name.size());
+        uint8_t type = static_cast<uint8_t>(op.type);
+        int32_t age = op.age;
+        std::memcpy(out + 8, &lsn, sizeof(lsn));
+        std::memcpy(out + HEADER_SIZE, &type, sizeof(type));
+        std::memcpy(out + HEADER_SIZE + 1, &age, sizeof(age));
+        std::memcpy(out + HEADER_SIZE + FIXED_PAYLOAD, op.name.data(), op.name.size());
+        uint32_t crc = crc32c(out + 8, 8 + length);
+        std::memcpy(out + 4, &crc, sizeof(crc));
+        // 长度最后写入：恢复时长度为 0 即视为段尾
+        std::memcpy(out, &length, sizeof(length));
+    }
+
+    // 解码 offset 处的记录，没有记录或校验失败时返回 false
+    static bool decode(const Segment& segment, std::size_t offset, Record& record) {
+        if (offset + HEADER_SIZE > segment.size) {
+            return false;
+        }
+        const char* in = segment.base + offset;
+        uint32_t length;
+        uint32_t crc;
+        std::memcpy(&length, in, sizeof(length));
+        std::memcpy(&crc, in + 4, sizeof(crc));
+        if (length < FIXED_PAYLOAD || offset + recordSize(length - FIXED_PAYLOAD) > segment.size ||
+            crc32c(in + 8, 8 + length) != crc) {
+            return false;
+        }
+        uint8_t type;
+        int32_t age;
+        std::memcpy(&record.lsn, in + 8, sizeof(record.lsn));
+        std::memcpy(&type, in + HEADER_SIZE, sizeof(type));
+        std::memcpy(&age, in + HEADER_SIZE + 1, sizeof(age));
+        if (type > static_cast<uint8_t>(BatchOp::Type::Delete)) {
+            return false;
+        }
+        record.size = recordSize(length - FIXED_PAYLOAD);
+        record.op.type = static_cast<BatchOp::Type>(type);
+        record.op.age = age;
+        record.op.name.assign(in + HEADER_SIZE + FIXED_PAYLOAD, length - FIXED_PAYLOAD);
+        return true;
+    }
+
+    std::string segmentPath(uint64_t first_lsn) const {
+        char name[64];
+        std::snprintf(name, sizeof(name), "wal-%020llu.log", static_cast<unsigned long long>(first_lsn));
+        return dir_ + "/" + name;
+    }
+
+    static void syncDirectory(const std::string& dir) {
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+
+    static std::shared_ptr<Segment> mapSegment(const std::string& path, uint64_t first_lsn,
+                                               std::size_t size, bool create) {
+        int fd = open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+        if (fd < 0) {
+            throw std::runtime_error("无法打开日志段 " + path + ": " + std::strerror(errno));
+        }
+        if (create) {
+            // 预先分配磁盘空间：之后写入映射区域不会因磁盘已满触发 SIGBUS
+            int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+            if (err != 0 || fsync(fd) != 0) {
+                close(fd);
+                unlink(path.c_str());
+                throw std::runtime_error("无法分配日志段 " + path + ": " + std::strerror(err != 0 ? err : errno));
+            }
+        } else {
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                close(fd);
+                throw std::runtime_error("日志段大小无效: " + path);
+            }
+            size = static_cast<std::size_t>(st.st_size);
+        }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("无法映射日志段 " + path + ": " + std::strerror(errno));
+        }
+        auto segment = std::make_shared<Segment>();
+        segment->first_lsn = first_lsn;
+        segment->last_lsn = first_lsn - 1;
+        segment->path = path;
+        segment->base = static_cast<char*>(base);
+        segment->size = size;
+        return segment;
+    }
+
+    std::shared_ptr<Segment> createSegment(uint64_t first_lsn) {
+        auto segment = mapSegment(segmentPath(first_lsn), first_lsn, segment_size_, true);
+        syncDirectory(dir_);
+        return segment;
+    }
+
+    // 启动时读取检查点并扫描全部日志段，恢复写入位置与写回游标
+    void recover() {
+        if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("无法创建日志目录 " + dir_ + ": " + std::strerror(errno));
+        }
+        std::string checkpoint_path = dir_ + "/checkpoint";
+        checkpoint_fd_ = open(checkpoint_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (checkpoint_fd_ < 0) {
+            throw std::runtime_error("无法打开检查点文件 " + checkpoint_path + ": " + std::strerror(errno));
+        }
+        uint64_t checkpoint = readCheckpoint();
+
+        std::vector<uint64_t> first_lsns;
+        if (DIR* dir = opendir(dir_.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                unsigned long long first_lsn;
+                char tail;
+                if (std::sscanf(entry->d_name, "wal-%20llu.lo%c", &first_lsn, &tail) == 2 && tail == 'g') {
+                    first_lsns.push_back(first_lsn);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(first_lsns.begin(), first_lsns.end());
+
+        uint64_t expected = 0;  // 下一条记录应有的 LSN，0 表示尚未读到任何日志段
+        bool truncated = false;
+        for (uint64_t first_lsn : first_lsns) {
+            std::string path = segmentPath(first_lsn);
+            if (truncated || (expected != 0 && first_lsn != expected)) {
+                // 截断点之后的日志段从未被确认过，直接丢弃
+                std::cerr << "丢弃不连续的日志段: " << path << std::endl;
+                unlink(path.c_str());
+                truncated = true;
+                continue;
+            }
+            auto segment = mapSegment(path, first_lsn, 0, false);
+            Record record;
+            std::size_t offset = 0;
+            uint64_t lsn = first_lsn;
+            while (decode(*segment, offset, record) && record.lsn == lsn) {
+                offset += record.size;
+                ++lsn;
+            }
+            segment->last_lsn = lsn - 1;
+            segment->write_offset = offset;
+            segment->synced_offset = offset;
+            if (std::any_of(segment->base + offset, segment->base + segment->size,
+                            [](char byte) { return byte != 0; })) {
+                // 最后一次 fsync 之前崩溃留下的残缺记录：清零，避免之后与新记录混在一起
+                std::cerr << "日志段 " << path << " 在偏移 " << offset << " 处截断" << std::endl;
+                std::memset(segment->base + offset, 0, segment->size - offset);
+                msync(segment->base, segment->size, MS_SYNC);
+                truncated = true;
+            }
+            expected = lsn;
+            segments_.push_back(std::move(segment));
+        }
+
+        // 已全部写回的日志段（检查点之后崩溃、尚未删除）
+        while (!segments_.empty() && segments_.front()->last_lsn <= checkpoint) {
+            unlink(segments_.front()->path.c_str());
+            segments_.pop_front();
+        }
+        if (segments_.empty()) {
+            segments_.push_back(createSegment(std::max(expected, checkpoint + 1)));
+        }
+
+        const auto& front = segments_.front();
+        applied_lsn_ = std::max(checkpoint, front->first_lsn - 1);
+        written_lsn_ = segments_.back()->last_lsn;
+        durable_lsn_ = written_lsn_;
+        next_lsn_ = written_lsn_ + 1;
+        replay_target_ = written_lsn_;
+
+        // 写回游标定位到检查点之后的第一条记录
+        read_segment_ = front;
+        read_offset_ = 0;
+        Record record;
+        while (decode(*front, read_offset_, record) && record.lsn <= applied_lsn_) {
+            read_offset_ += record.size;
+        }
+
+        if (written_lsn_ > applied_lsn_) {
+            std::cout << "延迟写回日志中有 " << written_lsn_ - applied_lsn_
+                      << " 条未写回的操作, 开始重放" << std::endl;
+        }
+    }
+
+    uint64_t readCheckpoint() {
+        char buffer[16];
+        if (pread(checkpoint_fd_, buffer, sizeof(buffer), 0) != static_cast<ssize_t>(sizeof(buffer))) {
+            return 0;
+        }
+        uint64_t lsn;
+        uint32_t crc;
+        std::memcpy(&lsn, buffer, sizeof(lsn));
+        std::memcpy(&crc, buffer + 8, sizeof(crc));
+        if (crc32c(buffer, sizeof(lsn)) != crc) {
+            std::cerr << "检查点校验失败, 从日志开头重放" << std::endl;
+            return 0;
+        }
+        return lsn;
+    }
+
+    void writeCheckpoint(uint64_t lsn) {
+        char buffer[16] = {};
+        uint32_t crc = crc32c(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+        std::memcpy(buffer, &lsn, sizeof(lsn));
+        std::memcpy(buffer + 8, &crc, sizeof(crc));
+        if (pwrite(checkpoint_fd_, buffer, sizeof(buffer), 0) != static_cast<ssize_t>(sizeof(buffer)) ||
+            fdatasync(checkpoint_fd_) != 0) {
+            // 检查点未落盘只会导致崩溃后多重放一些操作
+            std::cerr << "写入检查点失败: " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    // 组 fsync：一次 msync 覆盖这段时间内追加的所有记录，完成后统一确认
+    void syncLoop() {
+        struct Range {
+            std::shared_ptr<Segment> segment;
+            std::size_t from;
+            std::size_t to;
+        };
+        std::vector<Range> dirty;
+        std::deque<Waiter> done;
+        const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+        while (true) {
+            uint64_t target;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                sync_cond_.wait(lock, [this]() { return stop_ || !waiters_.empty(); });
+                if (waiters_.empty()) {
+                    return;
+                }
+                if (sync_window_.count() > 0 && !stop_) {
+                    sync_cond_.wait_for(lock, sync_window_, [this]() { return stop_; });
+                }
+                for (const auto& segment : segments_) {
+                    if (segment->write_offset > segment->synced_offset) {
+                        dirty.push_back(Range{segment, segment->synced_offset, segment->write_offset});
+                    }
+                }
+                target = written_lsn_;
+                done.swap(waiters_);
+            }
+
+            bool durable = true;
+            int error = 0;
+            for (const auto& range : dirty) {
+                std::size_t from = range.from & ~(page - 1);
+                if (msync(range.segment->base + from, range.to - from, MS_SYNC) != 0) {
+                    durable = false;
+                    error = errno;
+                }
+            }
+            fsyncs_.fetch_add(1, std::memory_order_relaxed);
+
+            if (durable) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (const auto& range : dirty) {
+                        range.segment->synced_offset = std::max(range.segment->synced_offset, range.to);
+                    }
+                    durable_lsn_ = target;
+                }
+                apply_cond_.notify_one();
+            } else {
+                // 写入方将收到失败，这些记录不能再写回或重放：作废全部未落盘的记录，
+                // 包括 fsync 期间新追加的（它们排在作废的记录之后，LSN 已不连续）
+                uint64_t discarded;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    discarded = written_lsn_ - durable_lsn_.load();
+                    truncateUnsynced(page);
+                    for (auto& waiter : waiters_) {
+                        done.push_back(std::move(waiter));
+                    }
+                    waiters_.clear();
+                }
+                sync_failures_.fetch_add(1, std::memory_order_relaxed);
+                applied_cond_.notify_all();
+                std::cerr << "延迟写回日志 fsync 失败, 作废未落盘的 " << discarded << " 条记录: "
+                          << std::strerror(error) << std::endl;
+            }
+            for (auto& waiter : done) {
+                try {
+                    waiter.done(durable);
+                } catch (const std::exception& e) {
+                    std::cerr << "延迟写回回调异常: " << e.what() << std::endl;
+                }
+            }
+            dirty.clear();
+            done.clear();
+        }
+    }
+
+    // 作废 durable_lsn_ 之后的记录：清零并回退写入位置，之后的写入从 durable_lsn_ + 1 接着写，
+    // 只含作废记录的日志段直接删除。写回线程只读取不超过 durable_lsn_ 的记录，不会读到这些位置。
+    // 调用方持有 mutex_
+    void truncateUnsynced(std::size_t page) {
+        uint64_t durable = durable_lsn_.load();
+        while (segments_.size() > 1 && segments_.back()->first_lsn > durable + 1) {
+            unlink(segments_.back()->path.c_str());
+            segments_.pop_back();
+        }
+        for (const auto& segment : segments_) {
+            if (segment->write_offset > segment->synced_offset) {
+                std::memset(segment->base + segment->synced_offset, 0,
+                            segment->write_offset - segment->synced_offset);
+                std::size_t from = segment->synced_offset & ~(page - 1);
+                // 尽力把清零落盘；失败时重启后的恢复可能重放这些记录（至少一次语义）
+                msync(segment->base + from, segment->write_offset - from, MS_SYNC);
+                segment->write_offset = segment->synced_offset;
+                segment->last_lsn = std::min(segment->last_lsn, durable);
+            }
+        }
+        written_lsn_ = durable;
+        next_lsn_ = durable + 1;
+    }
+
+    // 写回线程：按 LSN 顺序把已落盘的记录分批写回 MySQL，单线程保证同一行的写操作顺序不变
+    void applyLoop() {
+        std::vector<BatchOp> ops;
+        std::vector<BatchOpResult> results;
+        ops.reserve(max_batch_);
+        uint64_t last = 0;
+        std::chrono::milliseconds backoff(0);
+        bool paused = false;
+
+        while (true) {
+            if (ops.empty()) {
+                uint64_t durable;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    apply_cond_.wait(lock, [this]() { return stop_ || applied_lsn_.load() < durable_lsn_.load(); });
+                    if (stop_) {
+                        return;
+                    }
+                    durable = durable_lsn_.load();
+                }
+                last = readDurable(durable, ops);
+                if (ops.empty()) {
+                    continue;
+                }
+            }
+
+            // 主库熔断器断开：交给 executeBatch 也只会被拒绝，这一批留在日志中，等到下一次后台探测之后再试
+            if (!mgr_.writable()) {
+                apply_retries_.fetch_add(1, std::memory_order_relaxed);
+                if (!paused) {
+                    paused = true;
+                    std::cerr << "主库熔断器断开, 暂停写回 MySQL" << std::endl;
+                }
+                std::chrono::milliseconds wait = std::max(mgr_.retryAfter(), BREAKER_POLL);
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (apply_cond_.wait_for(lock, wait, [this]() { return stop_; })) {
+                    return;
+                }
+                continue;
+            }
+            if (paused) {
+                paused = false;
+                std::cout << "主库熔断器不再断开, 恢复写回 MySQL" << std::endl;
+            }
+
+            // 尽力模式：单条失败不影响同批其他操作，事务照常提交
+            bool committed = false;
+            try {
+                committed = mgr_.executeBatch(ops, false, results);
+            } catch (const std::exception& e) {
+                std::cerr << "写回 MySQL 异常: " << e.what() << std::endl;
+            }
+            if (!committed) {
+                // 这一批没有写入：数据库不可达、熔断器断开、死锁或提交失败。
+                // 客户端已经得到确认，保留这一批、检查点不前进，退避后重试
+                apply_retries_.fetch_add(1, std::memory_order_relaxed);
+                backoff = std::min(MAX_BACKOFF, std::max(MIN_BACKOFF, backoff * 2));
+                std::cerr << "写回 MySQL 失败, " << backoff.count() << "ms 后重试" << std::endl;
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (apply_cond_.wait_for(lock, backoff, [this]() { return stop_; })) {
+                    return;
+                }
+                continue;
+            }
+            backoff = std::chrono::milliseconds(0);
+
+            // 事务已提交，失败的只是被数据库拒绝的单条操作（如约束冲突、未命中记录），重试也不会成功
+
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                if (!results[i].success) {
+                    apply_failures_.fetch_add(1, std::memory_order_relaxed);
+                    std::cerr << "写回 MySQL 的操作失败, 已丢弃: " << ops[i].name << "/" << ops[i].age
+                              << ": " << results[i].message << std::endl;
+                }
+            }
+            if (on_applied_) {
+                on_applied_(ops);
+            }
+            writeCheckpoint(last);
+            releaseApplied(last);
+            ops.clear();
+        }
+    }
+
+    // 从写回游标开始解码至多 max_batch_ 条 LSN 不超过 durable 的记录，返回最后一条的 LSN。
+    // 已落盘的记录不会再被修改，解码无需持有 mutex_
+    uint64_t readDurable(uint64_t durable, std::vector<BatchOp>& ops) {
+        uint64_t last = applied_lsn_.load();
+        Record record;
+        while (ops.size() < max_batch_ && last < durable) {
+            if (!decode(*read_segment_, read_offset_, record)) {
+                std::shared_ptr<Segment> next = nextSegment(*read_segment_);
+                if (!next) {
+                    break;
+                }
+                read_segment_ = std::move(next);
+                read_offset_ = 0;
+                continue;
+            }
+            read_offset_ += record.size;
+            last = record.lsn;
+            ops.push_back(std::move(record.op));
+        }
+        return last;
+    }
+
+    std::shared_ptr<Segment> nextSegment(const Segment& current) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& segment : segments_) {
+            if (segment->first_lsn > current.first_lsn) {
+                return segment;
+            }
+        }
+        return nullptr;
+    }
+
+    // 推进检查点，删除已全部写回的日志段并唤醒等待空间的写入方
+    void releaseApplied(uint64_t lsn) {
+        std::vector<std::string> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            applied_lsn_ = lsn;
+            while (segments_.size() > 1 && segments_.front()->last_lsn <= lsn) {
+                removed.push_back(segments_.front()->path);
+                segments_.pop_front();
+            }
+        }
+        applied_cond_.notify_all();
+        for (const auto& path : removed) {
+            unlink(path.c_str());
+        }
+    }
+
+    static constexpr std::chrono::milliseconds MIN_BACKOFF{100};
+    static constexpr std::chrono::milliseconds MAX_BACKOFF{5000};
+    // 熔断器断开、下一次探测时间已到但尚未得出结果时，重新检查的间隔
+    static constexpr std::chrono::milliseconds BREAKER_POLL{10};
+
+    mysqlMgr& mgr_;
+    AppliedCallback on_applied_;
+    const std::string dir_;
+    const std::size_t segment_size_;
+    const std::size_t max_segments_;
+    const std::chrono::microseconds sync_window_;
+    const std::size_t max_batch_;
+    const std::chrono::milliseconds backpressure_wait_;
+
+    std::mutex mutex_;
+    std::condition_variable sync_cond_;     // 唤醒 fsync 线程
+    std::condition_variable apply_cond_;    // 唤醒写回线程
+    std::condition_variable applied_cond_;  // 写回推进：等待空间的写入方与等待重放完成的调用方
+    bool stop_ = false;
+    std::deque<std::shared_ptr<Segment>> segments_;
+    std::deque<Waiter> waiters_;
+    uint64_t next_lsn_ = 1;
+    uint64_t written_lsn_ = 0;
+    uint64_t replay_target_ = 0;
+    std::atomic<uint64_t> durable_lsn_{0};
+    std::atomic<uint64_t> applied_lsn_{0};
+
+    // 以下仅由写回线程访问
+    std::shared_ptr<Segment> read_segment_;
+    std::size_t read_offset_ = 0;
+    int checkpoint_fd_ = -1;
+
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> apply_failures_{0};
+    std::atomic<uint64_t> apply_retries_{0};
+    std::atomic<uint64_t> fsyncs_{0};
+    std::atomic<uint64_t> sync_failures_{0};
+
+    std::thread sync_thread_;
+    std::thread apply_thread_;
+};